@@ -70,11 +70,26 @@ fi
 fi
 fi
 
+# check if zlib is installed to decompress gzip input with reflex::DecompressBuffer
+cat > conftest.c << END
+#include <zlib.h>
+int main() { z_stream s; return inflateInit2(&s, 31); }
+END
+if cc -o conftest conftest.c -lz >& /dev/null ; then
+  DECOMPRESS_FLAGS='-DHAVE_LIBZ'
+  DECOMPRESS_LIBS='-lz'
+  echo "Compiling reflex with zlib to decompress gzip input"
+  echo
+else
+  DECOMPRESS_FLAGS=
+  DECOMPRESS_LIBS=
+fi
+
 # remove the conftest files
-rm -f conftest.c conftest.o
+rm -f conftest.c conftest.o conftest
 
 # compile
-cd lib; make -j -f Make CMFLAGS="$CMFLAGS" || exit 1; cd -
+cd lib; make -j -f Make CMFLAGS="$CMFLAGS" DECOMPRESS_FLAGS="$DECOMPRESS_FLAGS" DECOMPRESS_LIBS="$DECOMPRESS_LIBS" || exit 1; cd -
 cd src; make -j -f Make CMFLAGS="$CMFLAGS" || exit 1; cd -
 
 echo
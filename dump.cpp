@@ -0,0 +1,14 @@
+#ifndef REFLEX_CODE_DECL
+#include <reflex/pattern.h>
+#define REFLEX_CODE_DECL const reflex::Pattern::Opcode
+#endif
+
+extern REFLEX_CODE_DECL reflex_code_FSM[5] =
+{
+  0x05000003, // 0: GOTO 3 ON BWE
+  0x06000003, // 1: GOTO 3 ON EWE
+  0x00FFFFFF, // 2: HALT
+  0xFE000001, // 3: TAKE 1
+  0x00FFFFFF, // 4: HALT
+};
+
@@ -0,0 +1,101 @@
+// lex.yy.h generated by reflex 2.0.1 from calc.l
+
+#ifndef REFLEX_HEADER_H
+#define REFLEX_HEADER_H
+#define IN_HEADER 1
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  OPTIONS USED                                                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#define REFLEX_OPTION_bison_bridge        true
+#define REFLEX_OPTION_fast                true
+#define REFLEX_OPTION_freespace           true
+#define REFLEX_OPTION_header_file         "lex.yy.h"
+#define REFLEX_OPTION_interactive         true
+#define REFLEX_OPTION_lex                 lex
+#define REFLEX_OPTION_lexer               Lexer
+#define REFLEX_OPTION_outfile             "/tmp/o.cpp"
+#define REFLEX_OPTION_unicode             true
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  SECTION 1: %top user code                                                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#line 13 "calc.l"
+
+  #include <cstdlib>
+  #include <string>
+  #include <map>
+
+  // fixes problem with Bison 2.7 that needs the Lexer class type:
+  class REFLEX_OPTION_lexer;  // = %option lexer (which is 'Lexer' by default)
+
+  #include "y.tab.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  REGEX MATCHER                                                             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <reflex/matcher.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  ABSTRACT LEXER CLASS                                                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <reflex/abslexer.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  LEXER CLASS                                                               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+class Lexer : public reflex::AbstractLexer<reflex::Matcher> {
+#line 28 "calc.l"
+
+ public:
+  std::map<std::wstring,double> map;
+ private:
+  std::wstring                  var;
+
+ public:
+  typedef reflex::AbstractLexer<reflex::Matcher> AbstractBaseLexer;
+  Lexer(
+      const reflex::Input& input = reflex::Input(),
+      std::ostream&        os    = std::cout)
+    :
+      AbstractBaseLexer(input, os)
+  {
+  }
+  static const int INITIAL = 0;
+  virtual int lex(YYSTYPE& yylval);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  BISON BRIDGE                                                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+typedef Lexer yyscanner_t;
+typedef void *yyscan_t;
+
+#ifndef YY_EXTERN_C
+#define YY_EXTERN_C
+#endif
+
+YY_EXTERN_C int yylex(YYSTYPE*, yyscan_t);
+YY_EXTERN_C void yylex_init(yyscan_t*);
+YY_EXTERN_C void yylex_destroy(yyscan_t);
+
+#endif
@@ -91,6 +91,7 @@ class AbstractLexer {
       os_(&os),
       base_(NULL),
       size_(0),
+      rdo_(false),
       matcher_(NULL),
       start_(0),
       debug_(0),
@@ -180,6 +181,25 @@ class AbstractLexer {
     {
       base_ = base;
       size_ = size;
+      rdo_ = false;
+    }
+    return *this;
+  }
+  /// Reset the matcher and start scanning the given read-only buffer of size bytes in place, the buffer is never modified.
+  inline AbstractLexer& view(
+      const char *base, ///< base of the read-only buffer with character data, need not be 0-terminated
+      size_t      size) ///< size of the buffer
+    /// @returns reference to *this
+  {
+    if (has_matcher())
+    {
+      matcher().view(base, size); // reset and assign new read-only buffer
+    }
+    else
+    {
+      base_ = const_cast<char*>(base); // not modified, rdo_ is set
+      size_ = size;
+      rdo_ = true;
     }
     return *this;
   }
@@ -215,7 +235,10 @@ class AbstractLexer {
     matcher_ = matcher;
     if (matcher_ != NULL && base_ != NULL)
     {
-      matcher_->buffer(base_, size_);
+      if (rdo_)
+        matcher_->view(base_, size_);
+      else
+        matcher_->buffer(base_, size_);
       base_ = NULL;
       size_ = 0;
     }
@@ -416,6 +439,7 @@ class AbstractLexer {
   std::ostream        *os_;      ///< the output stream to echo text matches to
   char                *base_;    ///< the buffer to scan in place, if non-NULL
   size_t               size_;    ///< the size of the buffer to scan in place, if nonzero
+  bool                 rdo_;     ///< true if the buffer to scan in place is read-only, see view()
   Matcher             *matcher_; ///< the matcher used for scanning
   int                  start_;   ///< the current start condition state
   int                  debug_;   ///< 1 if -d (--debug) 0 otherwise:
@@ -317,6 +317,12 @@ class AbstractMatcher {
         }
       }
     }
+    if (in.mapped())
+    {
+      // scan a memory-mapped file in place, see reflex::MappedFile
+      view(in.cstring(), in.size());
+      return;
+    }
     if (!own_)
     {
 #if defined(WITH_REALLOC)
@@ -346,6 +352,7 @@ class AbstractMatcher {
 #endif
     num_ = 0;
     own_ = true;
+    rdo_ = false;
     eof_ = false;
     mat_ = false;
   }
@@ -438,11 +445,59 @@ class AbstractMatcher {
 #endif
       num_ = 0;
       own_ = false;
+      rdo_ = false;
       eof_ = true;
       mat_ = false;
     }
     return *this;
   }
+  /// Set the read-only buffer base containing size bytes of character data to scan in place, the buffer is never modified by this matcher, reset/restart the matcher.
+  AbstractMatcher& view(
+      const char *base, ///< base of the read-only buffer with character data, need not be 0-terminated
+      size_t      size) ///< size of the buffer
+    /// @returns this matcher
+  {
+    if (own_)
+    {
+#if defined(WITH_REALLOC)
+      std::free(static_cast<void*>(buf_));
+#else
+      delete[] buf_;
+#endif
+    }
+    buf_ = const_cast<char*>(base); // not modified, rdo_ is set
+    txt_ = buf_;
+    len_ = 0;
+    cap_ = 0;
+    cur_ = 0;
+    pos_ = 0;
+    end_ = size;
+    max_ = size + 1; // no room to read more input
+    ind_ = 0;
+    blk_ = 0;
+    got_ = Const::BOB;
+    chr_ = '\0';
+#if defined(WITH_SPAN)
+    bol_ = buf_;
+#endif
+    lpb_ = buf_;
+    lno_ = 1;
+#if !defined(WITH_SPAN)
+    cno_ = 0;
+#endif
+    num_ = 0;
+    own_ = false;
+    rdo_ = true;
+    eof_ = true;
+    mat_ = false;
+    return *this;
+  }
+  /// Returns true if this matcher scans a read-only buffer assigned with view().
+  bool readonly() const
+    /// @returns true if the buffer is read-only
+  {
+    return rdo_;
+  }
   
   /// Returns nonzero capture index (i.e. true) if the entire input matches this matcher's pattern (and internally caches the true/false result to permit repeat invocations).
   size_t matches()
@@ -474,6 +529,12 @@ class AbstractMatcher {
   const char *text()
     /// @returns 0-terminated const char* string with text matched
   {
+    if (rdo_)
+    {
+      // a read-only buffer cannot be 0-terminated, return a copy of the match
+      cpy_.assign(txt_, len_);
+      return cpy_.c_str();
+    }
     if (chr_ == '\0')
     {
       chr_ = txt_[len_];
@@ -528,43 +589,24 @@ class AbstractMatcher {
 #if defined(WITH_SPAN)
     if (lpb_ < txt_)
     {
-      while (bol_ < txt_)
-      {
-        char *s = static_cast<char*>(std::memchr(bol_, '\n', txt_ - bol_));
-        if (s == NULL)
-          break;
-        ++lno_;
-        bol_ = s + 1;
-      }
+      const char *b = bol_;
+      lno_ += count_lines(bol_, txt_, b);
+      bol_ = const_cast<char*>(b);
       lpb_ = txt_;
     }
 #else
-    size_t n = lno_;
-    size_t k = cno_;
-    char *s = lpb_;
-    char *e = txt_;
-    while (s < e)
+    if (lpb_ < txt_)
     {
-      if (*s == '\n')
-      {
-        ++n;
-        k = 0;
-      }
-      else if (*s == '\t')
+      const char *b = lpb_;
+      size_t n = count_lines(lpb_, txt_, b);
+      if (n > 0)
       {
-        // count tab spacing
-        k += 1 + (~k & (opt_.T - 1));
+        lno_ += n;
+        cno_ = 0;
       }
-      else
-      {
-        // count column offset in UTF-8 chars
-        k += ((*s & 0xC0) != 0x80);
-      }
-      ++s;
+      cno_ = count_columns(b, txt_, cno_, opt_.T);
+      lpb_ = txt_;
     }
-    lpb_ = e;
-    lno_ = n;
-    cno_ = k;
 #endif
     return lno_;
   }
@@ -572,11 +614,8 @@ class AbstractMatcher {
   size_t lines()
     /// @returns number of lines
   {
-    size_t n = 1;
-    const char *e = txt_ + len_;
-    for (const char *s = txt_; s < e; ++s)
-      n += (*s == '\n');
-    return n;
+    const char *b = txt_;
+    return 1 + count_lines(txt_, txt_ + len_, b);
   }
   /// Returns the inclusive ending line number of the match in the input character sequence.
   size_t lineno_end()
@@ -590,18 +629,7 @@ class AbstractMatcher {
   {
     (void)lineno();
 #if defined(WITH_SPAN)
-    const char *s = bol_;
-    const char *e = txt_;
-    size_t k = 0;
-    while (s < e)
-    {
-      if (*s == '\t')
-        k += 1 + (~k & (opt_.T - 1)); // count tab spacing
-      else
-        k += ((*s & 0xC0) != 0x80); // count column offset in UTF-8 chars
-      ++s;
-    }
-    return k;
+    return count_columns(bol_, txt_, 0, opt_.T);
 #else
     return cno_;
 #endif
@@ -661,19 +689,9 @@ class AbstractMatcher {
       return columno();
     (void)lineno();
     const char *e = txt_ + len_;
-    const char *s = e;
     const char *b = bol_;
-    while (--s >= b)
-      if (*s == '\n')
-        break;
-    size_t k = 0;
-    while (++s < e)
-    {
-      if (*s == '\t')
-        k += 1 + (~k & (opt_.T - 1));
-      else
-        k += (*s & 0xC0) != 0x80;
-    }
+    (void)count_lines(bol_, e, b);
+    size_t k = count_columns(b, e, 0, opt_.T);
     return k > 0 ? k - 1 : 0;
   }
 #endif
@@ -807,6 +825,13 @@ class AbstractMatcher {
   {
     DBGLOG("AbstractMatcher::unput()");
     reset_text();
+    if (rdo_)
+    {
+      // a read-only buffer cannot be modified, only back up over the same character
+      if (pos_ > 0 && buf_[pos_ - 1] == c)
+        cur_ = --pos_;
+      return;
+    }
     if (pos_ > 0)
     {
       --pos_;
@@ -829,6 +854,13 @@ class AbstractMatcher {
     DBGLOG("AbstractMatcher::wunput()");
     char tmp[8];
     size_t n = utf8(c, tmp);
+    if (rdo_)
+    {
+      // a read-only buffer cannot be modified, only back up over the same character
+      if (pos_ >= n && std::memcmp(buf_ + pos_ - n, tmp, n) == 0)
+        cur_ = pos_ -= n;
+      return;
+    }
     if (pos_ >= n)
     {
       pos_ -= n;
@@ -1192,7 +1224,7 @@ class AbstractMatcher {
   bool grow(size_t need = Const::BLOCK) ///< optional needed space = Const::BLOCK size by default
     /// @returns true if buffer was shifted or was enlarged
   {
-    if (max_ - end_ >= need + 1)
+    if (max_ - end_ >= need + 1 || rdo_)
       return false;
 #if defined(WITH_SPAN)
     update();
@@ -1382,6 +1414,21 @@ class AbstractMatcher {
       }
     }
   }
+  /// Returns the number of newlines in [s,e) and sets bol to the position after the last newline, bol is unchanged when [s,e) has no newlines.
+  static size_t count_lines(
+      const char  *s,   ///< begin of the text
+      const char  *e,   ///< end of the text
+      const char*& bol) ///< set to the begin of the last line in [s,e)
+    /// @returns number of newlines in [s,e)
+    ;
+  /// Returns column number k advanced over [s,e) without newlines, taking tab spacing t into account and counting wide characters as one character each.
+  static size_t count_columns(
+      const char *s, ///< begin of the text
+      const char *e, ///< end of the text
+      size_t      k, ///< column number at s
+      size_t      t) ///< tab size, a power of 2
+    /// @returns column number at e
+    ;
   /// Update the newline count, column count, and character count when shifting the buffer. 
   inline void update()
   {
@@ -1415,8 +1462,10 @@ class AbstractMatcher {
 #endif
   size_t num_; ///< character count (number of characters flushed prior to this buffered input)
   bool   own_; ///< true if AbstractMatcher::buf_ was allocated and should be deleted
+  bool   rdo_; ///< true if AbstractMatcher::buf_ is a read-only buffer assigned with view()
   bool   eof_; ///< input has reached EOF
   bool   mat_; ///< true if AbstractMatcher::matches() was successful
+  std::string cpy_; ///< copy of the match returned by text() when AbstractMatcher::buf_ is read-only
 };
 
 /// The pattern matcher class template extends abstract matcher base class.
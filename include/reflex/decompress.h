@@ -0,0 +1,214 @@
+/******************************************************************************\
+* Copyright (c) 2016, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      decompress.h
+@brief     Decompressing stream buffer for gzip, zstd and lz4 compressed input
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2016-2020, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#ifndef REFLEX_DECOMPRESS_H
+#define REFLEX_DECOMPRESS_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <streambuf>
+#include <vector>
+
+namespace reflex {
+
+/// Decompressing stream buffer to read gzip, zstd or lz4 compressed files, derived from std::streambuf.
+/**
+The compression format of the file is detected from its magic bytes.  Each
+decoder is optional and is compiled into the RE/flex library when configure
+detects its library, or when the library is compiled with the macro:
+
+  Format | Macro          | Library
+  ------ | -------------- | -----------------------------
+  gzip   | `HAVE_LIBZ`    | zlib, link with `-lz`
+  zstd   | `HAVE_LIBZSTD` | Zstandard, link with `-lzstd`
+  lz4    | `HAVE_LIBLZ4`  | LZ4 frames, link with `-llz4`
+
+Link with the libraries listed by `DECOMPRESS_LIBS` in the generated makefiles.
+Use supported() to check if the library has a decoder for a format.
+
+Uncompressed files and files compressed in a format without decoder are read
+as is.  Concatenated gzip members and multiple zstd and lz4 frames are
+decompressed in sequence.  When the stream is read in blocks, such as by a
+matcher that reads a std::istream, each block is decompressed directly into
+the matcher's buffer.  Use reflex::ReadAheadBuffer to decompress the file in a
+background thread while the matcher scans the decompressed input.
+
+Example:
+
+    FILE *file = fopen("logs.txt.gz", "rb");
+    if (file == NULL)
+      abort();
+    reflex::DecompressBuffer buffer(file);
+    std::istream stream(&buffer);
+    reflex::Matcher matcher("\\w+", stream);
+    while (matcher.find() != 0)
+      std::cout << matcher.text() << std::endl;
+    if (buffer.error())
+      std::cerr << "decompression error" << std::endl;
+    fclose(file);
+*/
+class DecompressBuffer : public std::streambuf {
+ public:
+  /// Buffer size of compressed input and of decompressed output read one character at a time.
+  static const size_t SIZE = 65536;
+  /// Common compression constants type.
+  typedef unsigned short compression_type;
+  /// Common compression constants.
+  struct compression {
+    static const compression_type plain = 0; ///< uncompressed or no decoder for the compression format
+    static const compression_type gzip  = 1; ///< gzip
+    static const compression_type zstd  = 2; ///< Zstandard
+    static const compression_type lz4   = 3; ///< LZ4 frames
+  };
+  /// Construct a decompressing stream buffer for a file opened in binary mode, the file is not closed by this object.
+  explicit DecompressBuffer(FILE *file) ///< open file
+    :
+      file_(file),
+      zip_(compression::plain),
+      in_(SIZE),
+      out_(SIZE),
+      pos_(0),
+      len_(0),
+      eof_(file == NULL),
+      end_(file == NULL),
+      fin_(true),
+      err_(false),
+      dec_(NULL)
+  {
+    fill();
+    init();
+  }
+  /// Delete the decompressor.
+  virtual ~DecompressBuffer()
+  {
+    done();
+  }
+  /// Returns true if the RE/flex library has a decoder for the compression format.
+  static bool supported(compression_type zip) ///< compression format
+    /// @returns true if supported
+    ;
+  /// Returns the compression format detected.
+  compression_type compression() const
+    /// @returns compression format or compression::plain
+  {
+    return zip_;
+  }
+  /// Returns true if the compressed input is corrupt or truncated.
+  bool error() const
+    /// @returns true if a decompression error occurred
+  {
+    return err_;
+  }
+ protected:
+  virtual int_type underflow()
+  {
+    if (gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
+    size_t k = decompress(&out_[0], SIZE);
+    if (k == 0)
+      return traits_type::eof();
+    setg(&out_[0], &out_[0], &out_[0] + k);
+    return traits_type::to_int_type(*gptr());
+  }
+  virtual std::streamsize xsgetn(char *s, std::streamsize n)
+  {
+    std::streamsize k = 0;
+    if (gptr() < egptr())
+    {
+      k = std::min<std::streamsize>(n, egptr() - gptr());
+      std::memcpy(s, gptr(), static_cast<size_t>(k));
+      gbump(static_cast<int>(k));
+    }
+    // decompress directly into s
+    while (k < n)
+    {
+      size_t l = decompress(s + k, static_cast<size_t>(n - k));
+      if (l == 0)
+        break;
+      k += static_cast<std::streamsize>(l);
+    }
+    return k;
+  }
+  virtual std::streamsize showmanyc()
+  {
+    return gptr() < egptr() ? egptr() - gptr() : end_ ? -1 : 0;
+  }
+  /// Read compressed input into in_[], keeping the input not yet decompressed.
+  void fill()
+  {
+    if (eof_)
+      return;
+    if (pos_ > 0)
+    {
+      std::memmove(&in_[0], &in_[pos_], len_ - pos_);
+      len_ -= pos_;
+      pos_ = 0;
+    }
+    size_t k = ::fread(&in_[len_], 1, SIZE - len_, file_);
+    len_ += k;
+    if (k == 0)
+      eof_ = true;
+  }
+  /// Detect the compression format from the magic bytes of the input and create its decoder.
+  void init();
+  /// Delete the decoder.
+  void done();
+  /// Decompress input into s of size n > 0.
+  size_t decompress(
+      /// @returns the nonzero number of bytes stored in s or zero when the end of the input is reached
+      char  *s, ///< points to the buffer to fill
+      size_t n) ///< size of the buffer
+    ;
+  FILE                *file_; ///< the compressed file
+  compression_type     zip_;  ///< compression format of the file
+  std::vector<char>    in_;   ///< compressed input
+  std::vector<char>    out_;  ///< decompressed output read one character at a time
+  size_t               pos_;  ///< position in in_[] of the input not yet decompressed
+  size_t               len_;  ///< length of the input in in_[]
+  bool                 eof_;  ///< true if the end of the file was reached
+  bool                 end_;  ///< true if the end of the decompressed stream was reached
+  bool                 fin_;  ///< true if the last gzip member or frame decompressed is complete
+  bool                 err_;  ///< true if a decompression error occurred
+  void                *dec_;  ///< decoder state, opaque to keep this header independent of the decompression libraries
+ private:
+  DecompressBuffer(const DecompressBuffer&); // not copyable
+  DecompressBuffer& operator=(const DecompressBuffer&); // not assignable
+};
+
+} // namespace reflex
+
+#endif
@@ -45,6 +45,110 @@
 
 namespace reflex {
 
+/// Memory-mapped file to scan in place with zero copy, falls back to reading the file with a FILE* when the file cannot be mapped.
+/**
+A regular file is mapped into memory read-only with mmap(2).  A reflex::Input
+constructed from a mapped file is scanned in place by the matcher as a
+read-only buffer assigned with AbstractMatcher::view(), without copying the
+file into the matcher's buffer.  A UTF-8 BOM is skipped.
+
+Pipes, TTYs and other files that are not regular files, empty files, and files
+with a UTF-16 or UTF-32 BOM are not mapped.  The reflex::Input constructed from
+such a file reads the file as usual with its `FILE*`, including the conversion
+of UTF-16 and UTF-32 to UTF-8.  A mapped file with a file encoding other than
+plain or UTF-8 is also read with its `FILE*` to decode it.  Mapping is not used
+on Windows or when the library is compiled with `-DWITH_NO_MMAP`.
+
+The mapped file should not be destroyed while the input is scanned.  A
+MappedFile cannot be copied.
+
+Example:
+
+    reflex::MappedFile file("input.c");
+    if (file.file() == NULL)
+      abort();
+    reflex::Matcher matcher("\\w+", file);
+    while (matcher.find() != 0)
+      std::cout << matcher.str() << std::endl;
+*/
+class MappedFile {
+ public:
+  /// Open the file with the given path and map it into memory, check file() != NULL to see if the file was opened.
+  explicit MappedFile(const char *path) ///< path of the file to open
+    :
+      file_(::fopen(path, "rb")),
+      close_(true),
+      base_(NULL),
+      len_(0),
+      data_(NULL),
+      size_(0)
+  {
+    map();
+  }
+  /// Map an open file into memory from its current position, the file is not closed by this object.
+  explicit MappedFile(FILE *file) ///< open file
+    :
+      file_(file),
+      close_(false),
+      base_(NULL),
+      len_(0),
+      data_(NULL),
+      size_(0)
+  {
+    map();
+  }
+  /// Unmap the file and close it when opened by this object.
+  ~MappedFile()
+  {
+    unmap();
+    if (close_ && file_ != NULL)
+      ::fclose(file_);
+  }
+  /// Returns true if the file is mapped into memory.
+  bool mapped() const
+    /// @returns true if mapped
+  {
+    return data_ != NULL;
+  }
+  /// Returns the mapped data of the file after its current position and after a UTF-8 BOM, or NULL when the file is not mapped.
+  const char *data() const
+    /// @returns pointer to read-only data or NULL
+  {
+    return data_;
+  }
+  /// Returns the size of the mapped data.
+  size_t size() const
+    /// @returns size of data() in bytes
+  {
+    return size_;
+  }
+  /// Returns the file offset of a position in the mapped data, to continue reading the file with its FILE* from this position.
+  size_t offset(const char *ptr) const ///< pointer into data()
+    /// @returns file offset
+  {
+    return static_cast<size_t>(ptr - static_cast<const char*>(base_));
+  }
+  /// Returns the FILE* of the file.
+  FILE *file() const
+    /// @returns FILE* or NULL when the file could not be opened
+  {
+    return file_;
+  }
+ private:
+  MappedFile(const MappedFile&); // not copyable
+  MappedFile& operator=(const MappedFile&); // not assignable
+  /// Map the file into memory when possible.
+  void map();
+  /// Unmap the file.
+  void unmap();
+  FILE       *file_;  ///< the file
+  bool        close_; ///< true if the file was opened by this object
+  void       *base_;  ///< base of the mapping or NULL
+  size_t      len_;   ///< length of the mapping
+  const char *data_;  ///< the data to scan in the mapping or NULL
+  size_t      size_;  ///< size of the data to scan
+};
+
 /// Input character sequence class for unified access to sources of input text.
 /**
 Description
@@ -337,7 +441,8 @@ class Input {
       size_(input.size_),
       uidx_(input.uidx_),
       utfx_(input.utfx_),
-      page_(input.page_)
+      page_(input.page_),
+      mapped_(input.mapped_)
   {
     std::memcpy(utf8_, input.utf8_, sizeof(utf8_));
   }
@@ -447,6 +552,37 @@ class Input {
     if (file_encoding() == file_encoding::plain)
       file_encoding(enc, page);
   }
+  /// Construct input character sequence from a memory-mapped file to scan in place, or from its FILE* when the file is not mapped.
+  Input(const MappedFile& file) ///< memory-mapped file
+    :
+      cstring_(file.data()),
+      wstring_(NULL),
+      file_(file.mapped() ? NULL : file.file()),
+      istream_(NULL),
+      size_(file.size())
+  {
+    init();
+    if (file.mapped())
+      mapped_ = &file;
+  }
+  /// Construct input character sequence from a memory-mapped file, using the specified file encoding, a file that is not plain or UTF-8 is read with its FILE* instead of in place.
+  Input(
+      const MappedFile&     file,        ///< memory-mapped file
+      file_encoding_type    enc,         ///< file_encoding (when UTF BOM is not present)
+      const unsigned short *page = NULL) ///< code page for file_encoding::custom
+    :
+      cstring_(file.data()),
+      wstring_(NULL),
+      file_(file.mapped() ? NULL : file.file()),
+      istream_(NULL),
+      size_(file.size())
+  {
+    init();
+    if (file.mapped())
+      mapped_ = &file;
+    if (file_encoding() == file_encoding::plain)
+      file_encoding(enc, page);
+  }
   /// Construct input character sequence from a std::istream.
   Input(std::istream& istream) ///< input stream
     :
@@ -480,6 +616,7 @@ class Input {
     uidx_ = input.uidx_;
     utfx_ = input.utfx_;
     page_ = input.page_;
+    mapped_ = input.mapped_;
     std::memcpy(utf8_, input.utf8_, sizeof(utf8_));
     return *this;
   }
@@ -560,6 +697,12 @@ class Input {
     }
     return size_;
   }
+  /// Check if this Input object is a memory-mapped file to scan in place, see reflex::MappedFile.
+  bool mapped() const
+    /// @returns true if the remaining cstring() of size() bytes is read-only mapped memory
+  {
+    return mapped_ != NULL && cstring_ != NULL;
+  }
   /// Check if this Input object was assigned a character sequence.
   bool assigned() const
     /// @returns true if this Input object was assigned (not default constructed or cleared)
@@ -574,6 +717,7 @@ class Input {
     file_ = NULL;
     istream_ = NULL;
     size_ = 0;
+    mapped_ = NULL;
   }
   /// Check if input is available.
   bool good() const
@@ -709,7 +853,7 @@ class Input {
     }
     return 0;
   }
-  /// Set encoding for `FILE*` input.
+  /// Set encoding for `FILE*` input, a memory-mapped file that is not plain or UTF-8 is read with its FILE* instead of in place.
   void file_encoding(
       file_encoding_type    enc,         ///< file_encoding
       const unsigned short *page = NULL) ///< custom code page for file_encoding::custom
@@ -727,6 +871,7 @@ class Input {
     uidx_ = sizeof(utf8_);
     utfx_ = 0;
     page_ = NULL;
+    mapped_ = NULL;
     if (file_ != NULL)
       file_init();
   }
@@ -743,6 +888,24 @@ class Input {
       char  *s, ///< points to the string buffer to fill with input
       size_t n) ///< size of buffer pointed to by s
       ;
+  /// Implements file_get() on a UTF-16 FILE* by reading and converting blocks of code units, returns the number of bytes stored in s, file_get() fills the last few bytes of s.
+  size_t file_get_utf16(
+      char  *s,  ///< points to the string buffer to fill with input
+      size_t n,  ///< size of buffer pointed to by s
+      bool   be) ///< true if big endian
+      ;
+  /// Implements file_get() on a FILE* with an 8-bit code page by reading and converting blocks of characters, returns the number of bytes stored in s, file_get() fills the last few bytes of s.
+  size_t file_get_page(
+      char                 *s,    ///< points to the string buffer to fill with input
+      size_t                n,    ///< size of buffer pointed to by s
+      const unsigned short *page) ///< code page or NULL for ISO-8859-1
+      ;
+  /// Implements file_get() on a UTF-32 FILE* by reading and converting blocks of code units, returns the number of bytes stored in s, file_get() fills the last few bytes of s.
+  size_t file_get_utf32(
+      char  *s,  ///< points to the string buffer to fill with input
+      size_t n,  ///< size of buffer pointed to by s
+      bool   be) ///< true if big endian
+      ;
  protected:
   const char           *cstring_; ///< char string input (when non-null) of length reflex::Input::size_
   const wchar_t        *wstring_; ///< NUL-terminated wide string input (when non-null)
@@ -753,6 +916,7 @@ class Input {
   unsigned short        uidx_;    ///< index in utf8_[] or >= 8 when unused
   file_encoding_type    utfx_;    ///< file_encoding
   const unsigned short *page_;    ///< custom code page
+  const MappedFile     *mapped_;  ///< memory-mapped file that cstring_ scans in place, or NULL
 };
 
 /// Stream buffer for reflex::Input, derived from std::streambuf.
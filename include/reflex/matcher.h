@@ -87,6 +87,7 @@ class Matcher : public PatternMatcher<reflex::Pattern> {
       ded_(matcher.ded_),
       tab_(matcher.tab_)
   {
+    lrv_ = matcher.lrv_;
     bmd_ = matcher.bmd_;
     if (bmd_ != 0)
       std::memcpy(bms_, matcher.bms_, sizeof(bms_));
@@ -97,6 +98,7 @@ class Matcher : public PatternMatcher<reflex::Pattern> {
     PatternMatcher<reflex::Pattern>::operator=(matcher);
     ded_ = matcher.ded_;
     tab_ = matcher.tab_;
+    lrv_ = matcher.lrv_;
     bmd_ = matcher.bmd_;
     if (bmd_ != 0)
       std::memcpy(bms_, matcher.bms_, sizeof(bms_));
@@ -114,6 +116,7 @@ class Matcher : public PatternMatcher<reflex::Pattern> {
     PatternMatcher<reflex::Pattern>::reset(opt);
     ded_ = 0;
     tab_.resize(0);
+    lrv_ = 0;
     bmd_ = 0;
   }
   virtual std::pair<const char*,size_t> operator[](size_t n) const
@@ -122,6 +125,22 @@ class Matcher : public PatternMatcher<reflex::Pattern> {
       return std::pair<const char*,size_t>(txt_, len_);
     return std::pair<const char*,size_t>(NULL, 0);
   }
+  /// A token matched by scan_batch().
+  struct Token {
+    size_t accept; ///< accept index of the token, as returned by scan()
+    size_t first;  ///< position of the token in the input character sequence, as returned by first()
+    size_t size;   ///< length of the token in bytes
+    size_t lineno; ///< line number of the token with scan_batch() option lines, otherwise 0
+  };
+  /// Scan the input for up to max tokens stored in out, returns the number of tokens stored, fewer than max when the input is exhausted or does not match the pattern.
+  size_t scan_batch(
+      Token *out,           ///< array of at least max tokens
+      size_t max,           ///< max number of tokens to scan
+      bool   lines = false) ///< also store the line number of each token
+    /// @returns number of tokens stored in out
+  {
+    return scan_batch_tables(out, max, lines, NULL, NULL);
+  }
   /// Returns the position of the last indent stop.
   size_t last_stop()
   {
@@ -360,6 +379,26 @@ class Matcher : public PatternMatcher<reflex::Pattern> {
   {
     return HW & (1ULL << 26);
   }
+  /// Check CPU hardware for AVX2 capability.
+  static bool have_HW_AVX2()
+  {
+    return HW & (1ULL << 37);
+  }
+  /// Check CPU hardware for SSSE3 capability.
+  static bool have_HW_SSSE3()
+  {
+    return HW & (1ULL << 9);
+  }
+  /// Check CPU hardware for ARM NEON/AArch64 ASIMD capability, meaningful only when built with ARM NEON.
+  static bool have_HW_NEON()
+  {
+    return HW & (1ULL << 1);
+  }
+  /// Check CPU hardware for AArch64 SVE capability, meaningful only when built with ARM NEON.
+  static bool have_HW_SVE()
+  {
+    return HW & (1ULL << 22);
+  }
  protected:
   typedef std::vector<size_t> Stops; ///< indent margin/tab stops
   /// FSM data for FSM code
@@ -376,6 +415,170 @@ class Matcher : public PatternMatcher<reflex::Pattern> {
   /// Returns true if input matched the pattern using method Const::SCAN, Const::FIND, Const::SPLIT, or Const::MATCH.
   virtual size_t match(Method method) ///< Const::SCAN, Const::FIND, Const::SPLIT, or Const::MATCH
     /// @returns nonzero if input matched the pattern
+  {
+    return match_tables(method, NULL, NULL);
+  }
+  /// Run the dense transition table tbl[] with byte classes bcl[] from its first row, returns the last character read.
+  int match_table(
+      const Pattern::Index *tbl, ///< dense transition table with rows [side, next[0], ..., next[ncl-1]]
+      const uint8_t        *bcl, ///< byte equivalence classes of the table
+      int                   c1)  ///< character before the match
+    /// @returns the last character read or EOF
+  {
+    // dense transition table: one indexed load per input byte, no meta transitions or lookaheads
+    const Pattern::Index *row = tbl;
+    while (true)
+    {
+      Pattern::Index side = *row;
+      DBGLOG("Table: row %zu side 0x%08X", static_cast<size_t>(row - tbl), side);
+      if (Pattern::is_table_redo(side))
+      {
+        cap_ = Const::REDO;
+        cur_ = pos_;
+        DBGLOG("Redo");
+      }
+      else if (Pattern::table_take(side) > 0)
+      {
+        cap_ = Pattern::table_take(side);
+        cur_ = pos_;
+        DBGLOG("Take: cap = %u", cap_);
+      }
+      if (Pattern::is_table_halt(side) || c1 == EOF)
+        break;
+      c1 = get();
+      DBGLOG("Get: c1 = %d", c1);
+      if (c1 == EOF)
+        break;
+      Pattern::Index jump = row[1 + bcl[c1]];
+      if (jump == 0)
+      {
+        // loop back to start state: failed to match anything so far?
+        if (cap_ == 0)
+          cur_ = pos_; // set cur_ to move forward from cur_ + 1 with FIND advance()
+      }
+      else if (jump == Pattern::Const::IMAX)
+      {
+        break;
+      }
+      row = tbl + jump;
+    }
+    return c1;
+  }
+  /// Match the strings of a pattern of many string alternatives with the trie of its Aho-Corasick automaton, the pattern has no DFA.
+  int match_trie(
+      const Pattern::AhoCorasick *aho, ///< automaton of the pattern
+      int                         c1)  ///< character before the match
+    /// @returns the last character read or EOF
+  {
+    // walk the trie from the root without failure links for the longest string, advance() located the leftmost string with the automaton
+    uint32_t state = 0;
+    while (true)
+    {
+      DBGLOG("Trie: state %u", state);
+      if (aho->accept[state] > 0)
+      {
+        cap_ = aho->accept[state];
+        cur_ = pos_;
+        DBGLOG("Take: cap = %u", cap_);
+      }
+      if (c1 == EOF)
+        break;
+      c1 = get();
+      DBGLOG("Get: c1 = %d", c1);
+      if (c1 == EOF)
+        break;
+      state = aho->child(state, aho->map[c1]);
+      if (state == 0)
+        break;
+    }
+    return c1;
+  }
+  /// Scan the input for up to max tokens stored in out with the static dense table stb of the pattern or NULL, without virtual calls and without materializing the text of the tokens.
+  size_t scan_batch_tables(
+      Token                *out,   ///< array of at least max tokens
+      size_t                max,   ///< max number of tokens to scan
+      bool                  lines, ///< also store the line number of each token
+      const Pattern::Index *stb,   ///< static dense transition table of the pattern or NULL
+      const uint8_t        *scl)   ///< byte equivalence classes of the static table
+    /// @returns number of tokens stored in out
+  {
+    const Pattern::Index *tbl = stb;
+    const uint8_t *bcl = scl;
+    if (tbl == NULL && pat_->fsm_ == NULL)
+    {
+      tbl = pat_->tbl_;
+      bcl = pat_->bcl_;
+    }
+    reset_text();
+    size_t n = 0;
+    while (n < max)
+    {
+      if (tbl != NULL && ded_ == 0)
+      {
+        // run the dense transition table directly on the buffered input for the longest match
+        size_t loc = cur_;
+        size_t pos = loc;
+        size_t end = loc;
+        size_t cap = 0;
+        const Pattern::Index *row = tbl;
+        while (true)
+        {
+          Pattern::Index side = *row;
+          if (Pattern::is_table_redo(side))
+          {
+            cap = Const::REDO;
+            end = pos;
+          }
+          else if (Pattern::table_take(side) > 0)
+          {
+            cap = Pattern::table_take(side);
+            end = pos;
+          }
+          if (Pattern::is_table_halt(side))
+            break;
+          if (pos >= end_)
+          {
+            cap = 0; // need more input, continue with match() below
+            break;
+          }
+          Pattern::Index jump = row[1 + bcl[static_cast<unsigned char>(buf_[pos++])]];
+          if (jump == Pattern::Const::IMAX)
+            break;
+          row = tbl + jump;
+        }
+        if (cap != 0 && end > loc)
+        {
+          set_current(end);
+          if (cap == Const::REDO && !opt_.A)
+            continue;
+          txt_ = buf_ + loc;
+          len_ = end - loc;
+          cap_ = cap;
+          Token& token = out[n++];
+          token.accept = cap;
+          token.first = num_ + loc;
+          token.size = len_;
+          token.lineno = lines ? lineno() : 0;
+          continue;
+        }
+      }
+      size_t accept = match_tables(Const::SCAN, stb, scl);
+      if (accept == 0)
+        break;
+      Token& token = out[n++];
+      token.accept = accept;
+      token.first = num_ + (txt_ - buf_);
+      token.size = len_;
+      token.lineno = lines ? lineno() : 0;
+    }
+    return n;
+  }
+  /// Returns true if input matched the pattern using method Const::SCAN, Const::FIND, Const::SPLIT, or Const::MATCH, with the static dense transition table stb of the pattern when non-NULL.
+  size_t match_tables(
+      Method                method, ///< Const::SCAN, Const::FIND, Const::SPLIT, or Const::MATCH
+      const Pattern::Index *stb,    ///< static dense transition table of the pattern or NULL
+      const uint8_t        *scl)    ///< byte equivalence classes of the static table
+    /// @returns nonzero if input matched the pattern
   {
     DBGLOG("BEGIN Matcher::match()");
     reset_text();
@@ -398,7 +601,11 @@ redo:
     lap_.resize(0);
     cap_ = 0;
     bool nul = method == Const::MATCH;
-    if (pat_->fsm_)
+    if (stb != NULL)
+    {
+      c1 = match_table(stb, scl, c1);
+    }
+    else if (pat_->fsm_)
     {
       DBGLOG("FSM code %p", pat_->fsm_);
       fsm_.bol = bol;
@@ -407,6 +614,52 @@ redo:
       nul = fsm_.nul;
       c1 = fsm_.c1;
     }
+    else if (pat_->tbl_ != NULL)
+    {
+      c1 = match_table(pat_->tbl_, pat_->bcl_, c1);
+    }
+    else if (pat_->lnf_ != NULL)
+    {
+      // lazy DFA: states are constructed on demand and cached, no meta transitions or lookaheads
+      Pattern::LazyDFA::State *state = ldf_.start(pat_);
+      while (true)
+      {
+        state = ldf_.expand(state);
+        DBGLOG("Lazy: state %p", state);
+        if (state->redo)
+        {
+          cap_ = Const::REDO;
+          cur_ = pos_;
+          DBGLOG("Redo");
+        }
+        else if (state->accept > 0)
+        {
+          cap_ = state->accept;
+          cur_ = pos_;
+          DBGLOG("Take: cap = %u", cap_);
+        }
+        if (state->halt || c1 == EOF)
+          break;
+        c1 = get();
+        DBGLOG("Get: c1 = %d", c1);
+        if (c1 == EOF)
+          break;
+        Pattern::LazyDFA::State *next = state->jump[c1];
+        if (next == NULL)
+          break;
+        if (next == ldf_.start())
+        {
+          // loop back to start state: failed to match anything so far?
+          if (cap_ == 0)
+            cur_ = pos_; // set cur_ to move forward from cur_ + 1 with FIND advance()
+        }
+        state = next;
+      }
+    }
+    else if (pat_->aho_ != NULL && pat_->opc_ == NULL)
+    {
+      c1 = match_trie(pat_->aho_, c1);
+    }
     else if (pat_->opc_)
     {
       const Pattern::Opcode *pc = pat_->opc_;
@@ -888,6 +1141,18 @@ unrolled:
   bool advance()
     /// @returns true if possible match found
     ;
+  /// Returns true if able to advance to the next string pre followed by a predicted match of at least min bytes.
+  bool advance_string(
+      const char *pre, ///< string to search
+      size_t      len, ///< nonzero length of the string, less than 256
+      size_t      min, ///< predict a match of at least min bytes after the string, 0 to skip prediction
+      size_t      loc) ///< location in the buffer to start searching
+    /// @returns true if the string is found
+    ;
+  /// Read more input to continue searching at loc, keeps the input from the bound lrv_ of the reverse DFA backward scan when applicable.
+  size_t advance_more(size_t loc) ///< location in the buffer to continue searching
+    /// @returns the location after the buffer was shifted to make room
+    ;
 #if !defined(WITH_NO_INDENT)
   /// Update indentation column counter for indent() and dedent().
   inline void newline()
@@ -930,9 +1195,11 @@ unrolled:
   std::vector<int>  lap_;      ///< lookahead position in input that heads a lookahead match (indexed by lookahead number)
   std::stack<Stops> stk_;      ///< stack to push/pop stops
   FSM               fsm_;      ///< local state for FSM code
+  Pattern::LazyDFA  ldf_;      ///< lazy DFA state cache for patterns compiled with option `l`
   uint16_t          lcp_;      ///< primary least common character position in the pattern prefix or 0xffff for pure Boyer-Moore
   uint16_t          lcs_;      ///< secondary least common character position in the pattern prefix or 0xffff for pure Boyer-Moore
   size_t            bmd_;      ///< Boyer-Moore jump distance on mismatch, B-M is enabled when bmd_ > 0
+  size_t            lrv_;      ///< lower bound in the buffer of the reverse DFA backward scan from a factor
   uint8_t           bms_[256]; ///< Boyer-Moore skip array
   bool              mrk_;      ///< indent \i or dedent \j in pattern found: should check and update indent stops
 };
@@ -0,0 +1,201 @@
+/******************************************************************************\
+* Copyright (c) 2016, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      parfinder.h
+@brief     C++11 multi-threaded search of large buffers with RE/flex matchers
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2016-2020, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#ifndef REFLEX_PARFINDER_H
+#define REFLEX_PARFINDER_H
+
+#include <reflex/matcher.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace reflex {
+
+/// Multi-threaded find() over a buffer split into chunks at line boundaries, searched by clones of a matcher.
+/**
+The buffer is split into chunks of about the given chunk size, each ending at
+a newline.  Threads search the chunks, each thread with a clone of the given
+matcher.  The matches are returned in input order with line and column numbers
+relative to the buffer.  Because the chunks are searched separately, a match
+cannot span lines at a chunk boundary, and `\A` and `^` without multi-line
+mode match at the start of each chunk.
+
+Example:
+
+    reflex::Matcher matcher("\\<(elit|eleifend)\\>");
+    reflex::ParallelFinder<> finder(matcher);
+    std::vector<reflex::ParallelFinder<>::Match> matches;
+    finder.find(base, size, matches);
+    for (size_t i = 0; i < matches.size(); ++i)
+      std::cout << matches[i].lineno << ": " << std::string(base + matches[i].first, matches[i].size) << std::endl;
+
+@tparam <M> matcher class with a `clone()` method returning `M*`, default reflex::Matcher
+*/
+template<typename M = Matcher>
+class ParallelFinder {
+ public:
+  static const size_t CHUNK = 1024 * 1024; ///< default chunk size in bytes
+  /// A match found in the buffer.
+  struct Match {
+    size_t first;   ///< position of the match in the buffer
+    size_t size;    ///< length of the match in bytes
+    size_t lineno;  ///< line number of the match, starting with 1
+    size_t columno; ///< column number of the match, starting with 0
+    size_t accept;  ///< accept index of the match, as returned by the matcher's accept()
+  };
+  /// Construct a parallel finder from a matcher with a pattern, the matcher is cloned for each thread.
+  explicit ParallelFinder(
+      M&     matcher,       ///< matcher to clone for each thread
+      size_t threads = 0,   ///< number of threads or 0 for all hardware threads
+      size_t chunk = CHUNK) ///< chunk size in bytes
+    :
+      mat_(matcher),
+      thr_(threads > 0 ? threads : std::max<size_t>(std::thread::hardware_concurrency(), 1)),
+      chk_(chunk > 0 ? chunk : 1)
+  { }
+  /// Find all matches in the buffer, returns the number of matches stored in matches in input order.
+  size_t find(
+      const char          *buf,     ///< buffer to search
+      size_t               len,     ///< length of the buffer in bytes
+      std::vector<Match>&  matches) ///< matches found
+  {
+    // split the buffer into chunks that end at a newline or at the end of the buffer
+    std::vector<size_t> bounds(1, 0);
+    while (bounds.back() < len)
+    {
+      size_t pos = bounds.back() + chk_;
+      if (pos >= len)
+      {
+        pos = len;
+      }
+      else
+      {
+        const char *s = static_cast<const char*>(std::memchr(buf + pos, '\n', len - pos));
+        pos = s != NULL ? s - buf + 1 : len;
+      }
+      bounds.push_back(pos);
+    }
+    size_t chunks = bounds.size() - 1;
+    std::vector<std::vector<Match> > found(chunks);
+    std::vector<size_t> lines(chunks);
+    std::atomic<size_t> next(0);
+    size_t workers = std::min(thr_, chunks);
+    std::vector<std::exception_ptr> errors(workers);
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; ++w)
+      pool.push_back(std::thread(&ParallelFinder::work, this, buf, &bounds, &found, &lines, &next, &errors[w]));
+    for (size_t w = 0; w < workers; ++w)
+      pool[w].join();
+    for (size_t w = 0; w < workers; ++w)
+      if (errors[w])
+        std::rethrow_exception(errors[w]);
+    // merge the matches in input order, offsetting line numbers by the number of lines of the preceding chunks
+    matches.clear();
+    size_t lineno = 0;
+    for (size_t i = 0; i < chunks; ++i)
+    {
+      for (typename std::vector<Match>::iterator j = found[i].begin(); j != found[i].end(); ++j)
+      {
+        j->lineno += lineno;
+        matches.push_back(*j);
+      }
+      lineno += lines[i];
+    }
+    return matches.size();
+  }
+ private:
+  /// Worker thread: search the next chunk with a clone of the matcher until all chunks are searched.
+  void work(
+      const char                       *buf,
+      const std::vector<size_t>        *bounds,
+      std::vector<std::vector<Match> > *found,
+      std::vector<size_t>              *lines,
+      std::atomic<size_t>              *next,
+      std::exception_ptr               *error)
+  {
+    M *matcher = NULL;
+    try
+    {
+      size_t i;
+      while ((i = next->fetch_add(1)) < found->size())
+      {
+        size_t from = (*bounds)[i];
+        size_t to = (*bounds)[i + 1];
+        if (matcher == NULL)
+          matcher = clone();
+        matcher->input(Input(buf + from, to - from));
+        std::vector<Match>& chunk = (*found)[i];
+        while (matcher->find())
+        {
+          Match match;
+          match.first = from + matcher->first();
+          match.size = matcher->size();
+          match.lineno = matcher->lineno();
+          match.columno = matcher->columno();
+          match.accept = matcher->accept();
+          chunk.push_back(match);
+        }
+        size_t n = 0;
+        for (const char *s = buf + from, *e = buf + to; (s = static_cast<const char*>(std::memchr(s, '\n', e - s))) != NULL; ++s)
+          ++n;
+        (*lines)[i] = n;
+      }
+    }
+    catch (...)
+    {
+      *error = std::current_exception();
+    }
+    delete matcher;
+  }
+  /// Clone the matcher, serialized because clone() is not const.
+  M *clone()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return mat_.clone();
+  }
+  M&         mat_; ///< matcher to clone
+  size_t     thr_; ///< number of threads
+  size_t     chk_; ///< chunk size
+  std::mutex mtx_; ///< serializes cloning of the matcher
+};
+
+} // namespace reflex
+
+#endif
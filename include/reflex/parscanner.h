@@ -0,0 +1,319 @@
+/******************************************************************************\
+* Copyright (c) 2016, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      parscanner.h
+@brief     C++11 speculative multi-threaded tokenization of large buffers with RE/flex matchers
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2016-2020, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#ifndef REFLEX_PARSCANNER_H
+#define REFLEX_PARSCANNER_H
+
+#include <reflex/matcher.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace reflex {
+
+/// Multi-threaded scan() over a buffer split into chunks at line boundaries, tokenized speculatively by clones of a matcher.
+/**
+The buffer is split into chunks of about the given chunk size, each starting
+at the begin of a line.  Threads tokenize the chunks with scan(), each chunk
+with a clone of the given matcher that speculates that a token starts at the
+begin of the chunk.  A speculative chunk tokenization continues past the end
+of the chunk until a token ends at or after the end of the chunk.
+
+The chunk tokenizations are stitched in input order.  The tokenization of a
+chunk is correct from the token that starts where the last token of the
+preceding chunks ends, because the matcher's DFA restarts in its initial state
+at each token with the same preceding character.  When no speculative token
+starts there, for example when a comment or string token spans the chunk
+boundary, the matcher of the preceding chunk resumes scanning serially until
+one of its tokens ends where a speculative token starts or until it crosses
+into the next chunk.  The result is identical to a serial scan() of the buffer
+with the given matcher, including line and column numbers.
+
+Tokenization stops when scan() returns zero, i.e. at the end of the buffer or
+when no pattern matches.  When the tokens do not cover the whole buffer, the
+end of the last token is the position of the unmatched input.  Actions that
+change the state of the tokenizer, such as start condition changes, cannot be
+speculated and are not supported.
+
+Example:
+
+    reflex::Matcher matcher("(\\w+)|(\\s+)|(.)");
+    reflex::ParallelScanner<> scanner(matcher);
+    std::vector<reflex::ParallelScanner<>::Token> tokens;
+    scanner.scan(base, size, tokens);
+    for (size_t i = 0; i < tokens.size(); ++i)
+      std::cout << tokens[i].accept << ": " << std::string(base + tokens[i].first, tokens[i].size) << std::endl;
+
+@tparam <M> matcher class with a `clone()` method returning `M*`, default reflex::Matcher
+*/
+template<typename M = Matcher>
+class ParallelScanner {
+ public:
+  static const size_t CHUNK = 1024 * 1024; ///< default chunk size in bytes
+  /// A token scanned in the buffer.
+  struct Token {
+    size_t first;   ///< position of the token in the buffer
+    size_t size;    ///< length of the token in bytes
+    size_t lineno;  ///< line number of the token, starting with 1
+    size_t columno; ///< column number of the token, starting with 0
+    size_t accept;  ///< accept index of the token, as returned by the matcher's scan()
+  };
+  /// Construct a parallel scanner from a matcher with a pattern, the matcher is cloned for each chunk.
+  explicit ParallelScanner(
+      M&     matcher,       ///< matcher to clone for each chunk
+      size_t threads = 0,   ///< number of threads or 0 for all hardware threads
+      size_t chunk = CHUNK) ///< chunk size in bytes
+    :
+      mat_(matcher),
+      thr_(threads > 0 ? threads : std::max<size_t>(std::thread::hardware_concurrency(), 1)),
+      chk_(chunk > 0 ? chunk : 1),
+      res_(0)
+  { }
+  /// Tokenize the buffer, returns the number of tokens stored in tokens in input order.
+  size_t scan(
+      const char         *buf,    ///< buffer to tokenize
+      size_t              len,    ///< length of the buffer in bytes
+      std::vector<Token>& tokens) ///< tokens scanned
+  {
+    // split the buffer into chunks that start at the begin of a line
+    std::vector<size_t> bounds(1, 0);
+    while (bounds.back() < len)
+    {
+      size_t pos = bounds.back() + chk_;
+      if (pos >= len)
+      {
+        pos = len;
+      }
+      else
+      {
+        const char *s = static_cast<const char*>(std::memchr(buf + pos, '\n', len - pos));
+        pos = s != NULL ? s - buf + 1 : len;
+      }
+      bounds.push_back(pos);
+    }
+    size_t chunks = bounds.size() - 1;
+    std::vector<Chunk> found(chunks);
+    std::atomic<size_t> next(0);
+    size_t workers = std::min(thr_, chunks);
+    std::vector<std::exception_ptr> errors(workers);
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; ++w)
+      pool.push_back(std::thread(&ParallelScanner::work, this, buf, len, &bounds, &found, &next, &errors[w]));
+    for (size_t w = 0; w < workers; ++w)
+      pool[w].join();
+    for (size_t w = 0; w < workers; ++w)
+    {
+      if (errors[w])
+      {
+        for (size_t i = 0; i < chunks; ++i)
+          delete found[i].matcher;
+        std::rethrow_exception(errors[w]);
+      }
+    }
+    stitch(bounds, found, tokens);
+    return tokens.size();
+  }
+  /// Returns the number of chunks that were mispredicted and rescanned in part by the last scan().
+  size_t rescans() const
+  {
+    return res_;
+  }
+ private:
+  /// Speculative tokenization of a chunk.
+  struct Chunk {
+    Chunk() : matcher(NULL), lines(0), stop(false) { }
+    std::vector<Token> tokens;  ///< tokens starting in the chunk
+    M                 *matcher; ///< matcher positioned after the last token
+    size_t             lines;   ///< number of lines in the chunk
+    bool               stop;    ///< true if scan() returned zero in the chunk
+  };
+  /// Worker thread: tokenize the next chunk with a clone of the matcher until all chunks are tokenized.
+  void work(
+      const char                *buf,
+      size_t                     len,
+      const std::vector<size_t> *bounds,
+      std::vector<Chunk>        *found,
+      std::atomic<size_t>       *next,
+      std::exception_ptr        *error)
+  {
+    try
+    {
+      size_t i;
+      while ((i = next->fetch_add(1)) < found->size())
+      {
+        size_t from = (*bounds)[i];
+        size_t to = (*bounds)[i + 1];
+        Chunk& chunk = (*found)[i];
+        M *matcher = chunk.matcher = clone();
+        matcher->input(Input(buf + from, len - from));
+        if (from > 0)
+        {
+          // the chunk starts after a newline, not at the begin of the buffer
+          matcher->set_bob(false);
+          matcher->set_bol(true);
+        }
+        chunk.stop = true;
+        while (add(*matcher, from, 0, chunk.tokens))
+        {
+          if (from + matcher->first() + matcher->size() >= to)
+          {
+            chunk.stop = false;
+            break;
+          }
+        }
+        for (const char *s = buf + from, *e = buf + to; (s = static_cast<const char*>(std::memchr(s, '\n', e - s))) != NULL; ++s)
+          ++chunk.lines;
+      }
+    }
+    catch (...)
+    {
+      *error = std::current_exception();
+    }
+  }
+  /// Stitch the speculative chunk tokenizations, resume scanning serially where a speculation failed.
+  void stitch(
+      const std::vector<size_t>& bounds,
+      std::vector<Chunk>&        found,
+      std::vector<Token>&        tokens)
+  {
+    tokens.clear();
+    res_ = 0;
+    M *matcher = NULL; // matcher positioned after the last token
+    size_t from = 0;   // position of the input of the matcher in the buffer
+    size_t lineno = 0; // number of lines before the input of the matcher
+    size_t lines = 0;  // number of lines before chunk i
+    size_t end = 0;    // end of the last token
+    bool stop = false;
+    for (size_t i = 0; i < found.size(); lines += found[i].lines, ++i)
+    {
+      Chunk& chunk = found[i];
+      if (stop || end >= bounds[i + 1])
+      {
+        delete chunk.matcher;
+        continue;
+      }
+      typename std::vector<Token>::iterator j = sync(chunk.tokens, end);
+      if (j == chunk.tokens.end() && !(chunk.tokens.empty() && chunk.stop && end == bounds[i]))
+      {
+        // misprediction: resume the matcher of the preceding chunks until it ends a token where a speculative token starts
+        ++res_;
+        while (true)
+        {
+          if (!add(*matcher, from, lineno, tokens))
+          {
+            stop = true;
+            break;
+          }
+          end = tokens.back().first + tokens.back().size;
+          if (end >= bounds[i + 1] || (j = sync(chunk.tokens, end)) != chunk.tokens.end())
+            break;
+        }
+        if (j == chunk.tokens.end())
+        {
+          delete chunk.matcher;
+          continue;
+        }
+      }
+      // the speculative tokens are correct from token j on
+      for (; j != chunk.tokens.end(); ++j)
+      {
+        tokens.push_back(*j);
+        tokens.back().lineno += lines;
+      }
+      if (!tokens.empty())
+        end = tokens.back().first + tokens.back().size;
+      delete matcher;
+      matcher = chunk.matcher;
+      from = bounds[i];
+      lineno = lines;
+      stop = chunk.stop;
+    }
+    delete matcher;
+  }
+  /// Scan the next token, returns false if scan() returned zero.
+  static bool add(
+      M&                  matcher,
+      size_t              from,
+      size_t              lineno,
+      std::vector<Token>& tokens)
+  {
+    size_t accept = matcher.scan();
+    if (accept == 0)
+      return false;
+    Token token;
+    token.first = from + matcher.first();
+    token.size = matcher.size();
+    token.lineno = lineno + matcher.lineno();
+    token.columno = matcher.columno();
+    token.accept = accept;
+    tokens.push_back(token);
+    return true;
+  }
+  /// Find the speculative token that starts at the given position.
+  static typename std::vector<Token>::iterator sync(
+      std::vector<Token>& tokens,
+      size_t              pos)
+  {
+    typename std::vector<Token>::iterator j = std::lower_bound(tokens.begin(), tokens.end(), pos, before);
+    if (j != tokens.end() && j->first != pos)
+      j = tokens.end();
+    return j;
+  }
+  /// Order of tokens by position.
+  static bool before(const Token& token, size_t pos)
+  {
+    return token.first < pos;
+  }
+  /// Clone the matcher, serialized because clone() is not const.
+  M *clone()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return mat_.clone();
+  }
+  M&         mat_; ///< matcher to clone
+  size_t     thr_; ///< number of threads
+  size_t     chk_; ///< chunk size
+  size_t     res_; ///< number of mispredicted chunks of the last scan()
+  std::mutex mtx_; ///< serializes cloning of the matcher
+};
+
+} // namespace reflex
+
+#endif
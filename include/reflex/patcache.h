@@ -0,0 +1,342 @@
+/******************************************************************************\
+* Copyright (c) 2016, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      patcache.h
+@brief     C++11 thread-safe cache of compiled RE/flex patterns
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2016-2020, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#ifndef REFLEX_PATCACHE_H
+#define REFLEX_PATCACHE_H
+
+#include <reflex/pattern.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace reflex {
+
+/// Thread-safe cache of compiled reflex::Pattern objects keyed by regex and options, shared by matchers.
+/**
+Cached patterns are immutable and reference counted.  A pattern evicted from
+the cache remains valid as long as a handle to it is kept.  Lookups of cached
+patterns do not lock and do not write shared memory: each thread keeps its own
+reference to an immutable snapshot of the cache table and only reloads the
+snapshot when the version counter of the cache changed, which happens when a
+pattern is added or evicted.  Hits are counted in counters that are sharded
+by thread.  Patterns are compiled without holding the mutex, after which a new
+snapshot with the pattern added is published.  A snapshot consists of a large
+table shared by snapshots and a table of the recently added patterns, which is
+merged into the large table when it exceeds the square root of its size, so a
+miss copies only the recent patterns in most cases.  The least recently used
+patterns are evicted when the estimated size of the cached patterns exceeds the
+byte budget of the cache, down to 15/16 of the budget so that evictions are
+batched.  Recency is tracked with a clock that advances with each miss, so hits
+only read the clock and mark a pattern used at most once per tick.
+
+A thread keeps its snapshot until its next lookup, so the memory of evicted
+patterns is released after the threads that used the cache looked up a
+pattern again or exited.
+
+Example:
+
+    reflex::PatternCache::Handle pattern = reflex::PatternCache::global().get("\\w+");
+    reflex::Matcher matcher(*pattern, "an apple a day");
+    while (matcher.find())
+      std::cout << matcher.text() << std::endl;
+*/
+class PatternCache {
+ public:
+  typedef std::shared_ptr<const Pattern> Handle; ///< handle to a shared compiled pattern
+  static const size_t BUDGET = 16 * 1024 * 1024; ///< default byte budget of a cache
+  /// Construct a pattern cache with a byte budget.
+  explicit PatternCache(size_t budget = BUDGET)
+    :
+      snp_(std::make_shared<const Snapshot>()),
+      ver_(0),
+      id_(next_id()),
+      bud_(budget),
+      byt_(0),
+      use_(0),
+      mis_(0),
+      evi_(0)
+  {
+    for (size_t i = 0; i < SHARDS; ++i)
+      hit_[i].n.store(0, std::memory_order_relaxed);
+  }
+  /// Get the process-wide pattern cache.
+  static PatternCache& global()
+  {
+    static PatternCache cache;
+    return cache;
+  }
+  /// Get the compiled pattern of a regex with options, the pattern is compiled and cached when not cached.
+  Handle get(
+      const std::string& regex,                     ///< regex string
+      const std::string& options = std::string())   ///< reflex::Pattern options
+    /// @returns handle to the shared compiled pattern
+    /// @throws reflex::regex_error when the regex is invalid with pattern option `r` or exceeds limits, errors are not cached
+  {
+    std::string key(regex);
+    key.push_back('\0');
+    key.append(options);
+    // look up the pattern in the snapshot of this thread, without locking and without taking a reference
+    const Entry *found = snapshot().find(key);
+    if (found != NULL)
+    {
+      // mark the entry used with the current tick, written at most once per tick to keep hits from contending
+      uint64_t now = use_.load(std::memory_order_relaxed);
+      if (found->use.load(std::memory_order_relaxed) != now)
+        found->use.store(now, std::memory_order_relaxed);
+      hit_[shard()].n.fetch_add(1, std::memory_order_relaxed);
+      return found->pattern;
+    }
+    mis_.fetch_add(1, std::memory_order_relaxed);
+    // compile the pattern without holding the mutex
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+    entry->pattern = std::make_shared<const Pattern>(regex, options);
+    entry->bytes = sizeof(Entry) + 2 * key.size() + entry->pattern->bytes();
+    entry->use.store(use_.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::shared_ptr<const Snapshot> snap = std::atomic_load(&snp_);
+    found = snap->find(key);
+    if (found != NULL)
+      return found->pattern; // another thread cached the same pattern meanwhile
+    byt_ += entry->bytes;
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>();
+    size_t limit = 16;
+    while (limit * limit < snap->base->size())
+      limit *= 2;
+    if (byt_ > bud_ || snap->recent.size() >= limit)
+    {
+      // merge the recent patterns into a new large table, at most once per square root of its size misses unless evicting
+      std::shared_ptr<Table> base = std::make_shared<Table>(*snap->base);
+      base->insert(snap->recent.begin(), snap->recent.end());
+      (*base)[key] = entry;
+      evict(*base, &key);
+      next->base = base;
+    }
+    else
+    {
+      next->base = snap->base;
+      next->recent = snap->recent;
+      next->recent[key] = entry;
+    }
+    publish(next);
+    return entry->pattern;
+  }
+  /// Get the compiled pattern of a regex with options, the pattern is compiled and cached when not cached.
+  Handle get(
+      const char *regex,           ///< regex string
+      const char *options = NULL)  ///< reflex::Pattern options or NULL
+    /// @returns handle to the shared compiled pattern
+  {
+    return get(std::string(regex), std::string(options != NULL ? options : ""));
+  }
+  /// Set the byte budget, evicts patterns when the cached patterns exceed the new budget.
+  void budget(size_t budget)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    bud_ = budget;
+    if (byt_ > bud_)
+    {
+      std::shared_ptr<const Snapshot> snap = std::atomic_load(&snp_);
+      std::shared_ptr<Table> base = std::make_shared<Table>(*snap->base);
+      base->insert(snap->recent.begin(), snap->recent.end());
+      evict(*base, NULL);
+      std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>();
+      next->base = base;
+      publish(next);
+    }
+  }
+  /// Get the byte budget.
+  size_t budget() const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return bud_;
+  }
+  /// Remove all patterns from the cache, patterns remain valid as long as handles to them are kept.
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    byt_ = 0;
+    publish(std::make_shared<Snapshot>());
+  }
+  /// Get the number of cached patterns.
+  size_t size() const
+  {
+    std::shared_ptr<const Snapshot> snap = std::atomic_load(&snp_);
+    return snap->base->size() + snap->recent.size();
+  }
+  /// Get the estimated number of bytes of the cached patterns.
+  size_t bytes() const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return byt_;
+  }
+  /// Get the number of lookups that found a cached pattern.
+  size_t hits() const
+  {
+    size_t n = 0;
+    for (size_t i = 0; i < SHARDS; ++i)
+      n += hit_[i].n.load(std::memory_order_relaxed);
+    return n;
+  }
+  /// Get the number of lookups that compiled a pattern.
+  size_t misses() const
+  {
+    return mis_.load(std::memory_order_relaxed);
+  }
+  /// Get the number of patterns evicted from the cache.
+  size_t evictions() const
+  {
+    return evi_.load(std::memory_order_relaxed);
+  }
+ private:
+  PatternCache(const PatternCache&);
+  PatternCache& operator=(const PatternCache&);
+  static const size_t SHARDS = 16; ///< number of hit counters, threads are assigned to counters round robin
+  static const size_t SLOTS  = 4;  ///< number of caches a thread keeps a snapshot of, by cache id
+  /// Cached pattern with its estimated size and last use.
+  struct Entry {
+    Handle                        pattern; ///< the compiled pattern
+    size_t                        bytes;   ///< estimated size of the pattern and its key
+    mutable std::atomic<uint64_t> use;     ///< tick of the last use, larger is more recent
+  };
+  typedef std::unordered_map<std::string,std::shared_ptr<Entry> > Table;
+  /// Immutable snapshot of the cached patterns.
+  struct Snapshot {
+    Snapshot()
+      :
+        base(std::make_shared<const Table>())
+    { }
+    /// Returns the entry of a key or NULL when not cached.
+    const Entry *find(const std::string& key) const
+    {
+      if (!recent.empty())
+      {
+        Table::const_iterator i = recent.find(key);
+        if (i != recent.end())
+          return i->second.get();
+      }
+      Table::const_iterator i = base->find(key);
+      return i != base->end() ? i->second.get() : NULL;
+    }
+    std::shared_ptr<const Table> base;   ///< large table of patterns shared by snapshots
+    Table                        recent; ///< patterns added since the large table was last copied
+  };
+  /// Snapshot of a cache kept by a thread.
+  struct Slot {
+    Slot() : id(0), ver(0) { }
+    uint64_t                        id;   ///< id of the cache or 0 when unused
+    uint64_t                        ver;  ///< version of the cache when the snapshot was loaded
+    std::shared_ptr<const Snapshot> snap; ///< snapshot of the cache
+  };
+  /// Hit counter padded to a cache line to keep threads from contending.
+  struct Counter {
+    std::atomic<size_t> n;
+    char                pad[64 - sizeof(std::atomic<size_t>)];
+  };
+  /// Returns a new cache id, never 0.
+  static uint64_t next_id()
+  {
+    static std::atomic<uint64_t> id(0);
+    return id.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+  /// Returns the hit counter shard of this thread.
+  static size_t shard()
+  {
+    static std::atomic<size_t> next(0);
+    static thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return index;
+  }
+  /// Returns the snapshot of this thread, reloaded only when the cache version changed.
+  const Snapshot& snapshot() const
+  {
+    static thread_local Slot slots[SLOTS];
+    Slot& slot = slots[id_ % SLOTS];
+    uint64_t ver = ver_.load(std::memory_order_acquire);
+    if (slot.id != id_ || slot.ver != ver)
+    {
+      slot.snap = std::atomic_load(&snp_);
+      slot.id = id_;
+      slot.ver = ver;
+    }
+    return *slot.snap;
+  }
+  /// Publish a new snapshot, then advance the version for threads to reload their snapshot, with the mutex held.
+  void publish(const std::shared_ptr<const Snapshot>& snap)
+  {
+    std::atomic_store(&snp_, snap);
+    ver_.fetch_add(1, std::memory_order_release);
+  }
+  /// Evict the least recently used patterns, but not the pattern with the key to keep, down to 15/16 of the budget.
+  void evict(Table& table, const std::string *keep)
+  {
+    if (byt_ <= bud_)
+      return;
+    size_t target = bud_ - bud_ / 16;
+    std::vector<std::pair<uint64_t,Table::iterator> > lru;
+    lru.reserve(table.size());
+    for (Table::iterator i = table.begin(); i != table.end(); ++i)
+      if (keep == NULL || i->first != *keep)
+        lru.push_back(std::pair<uint64_t,Table::iterator>(i->second->use.load(std::memory_order_relaxed), i));
+    std::sort(lru.begin(), lru.end(), older);
+    for (std::vector<std::pair<uint64_t,Table::iterator> >::iterator i = lru.begin(); i != lru.end() && byt_ > target; ++i)
+    {
+      byt_ -= i->second->second->bytes;
+      table.erase(i->second);
+      evi_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  /// Order entries by their last use.
+  static bool older(const std::pair<uint64_t,Table::iterator>& a, const std::pair<uint64_t,Table::iterator>& b)
+  {
+    return a.first < b.first;
+  }
+  std::shared_ptr<const Snapshot> snp_;         ///< current snapshot, replaced atomically
+  std::atomic<uint64_t>           ver_;         ///< version of the snapshot, advanced after a new snapshot is published
+  const uint64_t                  id_;          ///< id of this cache to find the snapshot of a thread
+  mutable std::mutex              mtx_;         ///< serializes updates of the snapshot
+  size_t                          bud_;         ///< byte budget
+  size_t                          byt_;         ///< estimated number of bytes of the cached patterns
+  std::atomic<uint64_t>           use_;         ///< use clock that ticks with each miss, to order entries by their last use
+  Counter                         hit_[SHARDS]; ///< number of hits, sharded by thread
+  std::atomic<size_t>             mis_;         ///< number of misses
+  std::atomic<size_t>             evi_;         ///< number of evictions
+};
+
+} // namespace reflex
+
+#endif
@@ -58,11 +58,14 @@
 
 namespace reflex {
 
+template<typename T> class StaticMatcher;
+
 /// Pattern class holds a regex pattern and its compiled FSM opcode table or code for the reflex::Matcher engine.
 /** More info TODO */
 class Pattern {
   friend class Matcher;      ///< permit access by the reflex::Matcher engine
   friend class FuzzyMatcher; ///< permit access by the reflex::FuzzyMatcher engine
+  template<typename T> friend class StaticMatcher; ///< permit access by the reflex::StaticMatcher engine
  public:
   typedef uint8_t  Pred;   ///< predict match bits
   typedef uint16_t Hash;   ///< hash value type, max value is Const::HASH
@@ -79,13 +82,25 @@ class Pattern {
     static const Index  LONG = 0xFFFE;     ///< LONG marker for 64 bit opcodes, must be HALT-1
     static const Index  HALT = 0xFFFF;     ///< HALT marker for GOTO opcodes, must be 16 bit max
     static const Hash   HASH = 0x1000;     ///< size of the predict match array
+    static const Index  TMAX = 0x100000;   ///< max number of words of a dense transition table
+    static const Index  NMAX = 256;        ///< max number of literal paths predicted with nibble tables
+    static const Index  BMIN = 4;          ///< min number of transitions of a state to generate binary search code with option g
+    static const Index  JMIN = 16;         ///< default min number of transitions of a state to generate a switch jump table with option g
+    static const Index  MAGIC = 0x52455046; ///< magic number of a compiled pattern file, see save()
+    static const Index  FORMAT = 1;         ///< version of the compiled pattern file format
   };
   /// Construct an unset pattern.
   explicit Pattern()
     :
       opc_(NULL),
       nop_(0),
-      fsm_(NULL)
+      fsm_(NULL),
+      tbl_(NULL),
+      ncl_(0),
+      lnf_(NULL),
+      aho_(NULL),
+      rev_(NULL),
+      map_(NULL)
   { }
   /// Construct a pattern object given a regex string.
   explicit Pattern(
@@ -94,7 +109,12 @@ class Pattern {
     :
       rex_(regex),
       opc_(NULL),
-      fsm_(NULL)
+      fsm_(NULL),
+      tbl_(NULL),
+      lnf_(NULL),
+      aho_(NULL),
+      rev_(NULL),
+      map_(NULL)
   {
     init(options);
   }
@@ -105,7 +125,12 @@ class Pattern {
     :
       rex_(regex),
       opc_(NULL),
-      fsm_(NULL)
+      fsm_(NULL),
+      tbl_(NULL),
+      lnf_(NULL),
+      aho_(NULL),
+      rev_(NULL),
+      map_(NULL)
   {
     init(options.c_str());
   }
@@ -116,7 +141,12 @@ class Pattern {
     :
       rex_(regex),
       opc_(NULL),
-      fsm_(NULL)
+      fsm_(NULL),
+      tbl_(NULL),
+      lnf_(NULL),
+      aho_(NULL),
+      rev_(NULL),
+      map_(NULL)
   {
     init(options);
   }
@@ -127,7 +157,12 @@ class Pattern {
     :
       rex_(regex),
       opc_(NULL),
-      fsm_(NULL)
+      fsm_(NULL),
+      tbl_(NULL),
+      lnf_(NULL),
+      aho_(NULL),
+      rev_(NULL),
+      map_(NULL)
   {
     init(options.c_str());
   }
@@ -138,7 +173,12 @@ class Pattern {
     :
       opc_(code),
       nop_(0),
-      fsm_(NULL)
+      fsm_(NULL),
+      tbl_(NULL),
+      lnf_(NULL),
+      aho_(NULL),
+      rev_(NULL),
+      map_(NULL)
   {
     init(NULL, pred);
   }
@@ -149,12 +189,27 @@ class Pattern {
     :
       opc_(NULL),
       nop_(0),
-      fsm_(fsm)
+      fsm_(fsm),
+      tbl_(NULL),
+      lnf_(NULL),
+      aho_(NULL),
+      rev_(NULL),
+      map_(NULL)
   {
     init(NULL, pred);
   }
   /// Copy constructor.
   Pattern(const Pattern& pattern) ///< pattern to copy
+    :
+      opc_(NULL),
+      nop_(0),
+      fsm_(NULL),
+      tbl_(NULL),
+      ncl_(0),
+      lnf_(NULL),
+      aho_(NULL),
+      rev_(NULL),
+      map_(NULL)
   {
     operator=(pattern);
   }
@@ -167,11 +222,25 @@ class Pattern {
   void clear()
   {
     rex_.clear();
-    if (nop_ > 0 && opc_ != NULL)
+    if (map_ != NULL)
+      unmap();
+    else if (nop_ > 0 && opc_ != NULL)
       delete[] opc_;
     opc_ = NULL;
     nop_ = 0;
     fsm_ = NULL;
+    if (tbl_ != NULL)
+      delete[] tbl_;
+    tbl_ = NULL;
+    if (lnf_ != NULL)
+      delete lnf_;
+    lnf_ = NULL;
+    if (aho_ != NULL)
+      delete aho_;
+    aho_ = NULL;
+    if (rev_ != NULL)
+      delete rev_;
+    rev_ = NULL;
   }
   /// Assign a (new) pattern.
   Pattern& assign(
@@ -248,8 +317,39 @@ class Pattern {
     }
     else
     {
+      opc_ = pattern.opc_;
       fsm_ = pattern.fsm_;
     }
+    len_ = pattern.len_;
+    min_ = pattern.min_;
+    one_ = pattern.one_;
+    memcpy(pre_, pattern.pre_, len_);
+    memcpy(bit_, pattern.bit_, sizeof(bit_));
+    memcpy(pmh_, pattern.pmh_, sizeof(pmh_));
+    memcpy(pma_, pattern.pma_, sizeof(pma_));
+    nbp_ = pattern.nbp_;
+    memcpy(nib_, pattern.nib_, sizeof(nib_));
+    wbl_ = pattern.wbl_;
+    if (wbl_ > 0)
+      memcpy(wbp_, pattern.wbp_, sizeof(wbp_));
+    ncl_ = pattern.ncl_;
+    if (ncl_ > 0)
+      memcpy(bcl_, pattern.bcl_, sizeof(bcl_));
+    if (pattern.tbl_ != NULL)
+    {
+      nrw_ = pattern.nrw_;
+      size_t n = static_cast<size_t>(nrw_) * (ncl_ + 1);
+      Index *table = new Index[n];
+      for (size_t i = 0; i < n; ++i)
+        table[i] = pattern.tbl_[i];
+      tbl_ = table;
+    }
+    if (pattern.lnf_ != NULL)
+      lnf_ = new LazyNFA(*pattern.lnf_);
+    if (pattern.aho_ != NULL)
+      aho_ = new AhoCorasick(*pattern.aho_);
+    if (pattern.rev_ != NULL)
+      rev_ = new ReverseDFA(*pattern.rev_);
     return *this;
   }
   /// Assign a (new) pattern.
@@ -282,8 +382,16 @@ class Pattern {
   bool empty() const
     /// @return true if this pattern is not assigned
   {
-    return opc_ == NULL && fsm_ == NULL;
+    return opc_ == NULL && fsm_ == NULL && lnf_ == NULL && aho_ == NULL;
   }
+  /// Save the compiled pattern to a binary file, to load with load_mapped().
+  bool save(const char *filename) const
+    /// @returns true if saved, false when the file cannot be written or this pattern has no opcode table
+    ;
+  /// Load a compiled pattern saved with save(), the opcode table is memory mapped and used without copying, the file must not be truncated or rewritten while this pattern uses it.
+  bool load_mapped(const char *filename)
+    /// @returns true if loaded, false when the file cannot be read or is not a valid compiled pattern file
+    ;
   /// Get subpattern regex of this pattern object or the whole regex with index 0.
   const std::string operator[](Accept choice) const
     /// @returns subpattern string or "" when not set
@@ -298,13 +406,13 @@ class Pattern {
   size_t nodes() const
     /// @returns number of nodes or 0 when no finite state machine was constructed by this pattern
   {
-    return nop_ > 0 ? vno_ : 0;
+    return nop_ > 0 || aho_ != NULL ? vno_ : 0;
   }
   /// Get the number of finite state machine edges (transitions on input characters).
   size_t edges() const
     /// @returns number of edges or 0 when no finite state machine was constructed by this pattern
   {
-    return nop_ > 0 ? eno_ : 0;
+    return nop_ > 0 || aho_ != NULL ? eno_ : 0;
   }
   /// Get the code size in number of words.
   size_t words() const
@@ -312,6 +420,34 @@ class Pattern {
   {
     return nop_;
   }
+  /// Get the number of byte equivalence classes of the DFA, bytes in the same class make the same transitions, computed with option `d`, `h` or `o`.
+  size_t byte_classes() const
+    /// @returns number of byte classes or 0 when no byte classes were computed by this pattern
+  {
+    return ncl_;
+  }
+  /// Get the byte equivalence class table of the DFA, valid when byte_classes() > 0.
+  const uint8_t *byte_class() const
+    /// @returns pointer to 256 byte class ids, ranging from 0 to byte_classes() - 1
+  {
+    return bcl_;
+  }
+  /// Get the dense transition table with rows [side, next[0], ..., next[byte_classes()-1]], see option `d`.
+  const Index *table() const
+    /// @returns pointer to the table or NULL when no dense transition table was generated by this pattern
+  {
+    return tbl_;
+  }
+  /// Get the number of words of the dense transition table, see option `d`.
+  size_t table_words() const
+    /// @returns number of words or 0 when no dense transition table was generated by this pattern
+  {
+    return tbl_ != NULL ? static_cast<size_t>(nrw_) * (ncl_ + 1) : 0;
+  }
+  /// Get the estimated number of bytes of memory used by this pattern, including its opcode table, dense transition table, lazy NFA and search automata.
+  size_t bytes() const
+    /// @returns estimated number of bytes
+    ;
   /// Get elapsed regex parsing and analysis time.
   float parse_time() const
   {
@@ -332,6 +468,14 @@ class Pattern {
   {
     return wms_;
   }
+  /// Returns true when match is predicted by the 64-bit bitap array wbp[] of the first n bytes s[0..n-1].
+  static inline bool predict_match(const uint64_t wbp[], size_t n, const char *s)
+  {
+    for (size_t i = 0; i < n; ++i)
+      if ((wbp[static_cast<uint8_t>(s[i])] >> i) & 1)
+        return false;
+    return true;
+  }
   /// Returns true when match is predicted, based on s[0..3..e-1] (e >= s + 4).
   static inline bool predict_match(const Pred pmh[], const char *s, size_t n)
   {
@@ -475,8 +619,11 @@ class Pattern {
   typedef std::set<Lazy>               Lazyset;
   typedef std::set<Position>           Positions;
   typedef std::map<Position,Positions> Follow;
-  typedef std::pair<Chars,Positions>   Move;
+  typedef std::vector<Position>        Flatpos;    ///< sorted vector of positions used by subset construction
+  typedef std::map<Position,Flatpos>   Flatfollow; ///< followpos with sorted vectors used by subset construction
+  typedef std::pair<Chars,Flatpos>     Move;
   typedef std::list<Move>              Moves;
+  typedef std::vector<std::pair<Char,std::pair<Char,Index> > > Jumps; ///< sorted byte ranges [lo,hi] with target state index of generated FSM code
   /// Tree DFA constructed from string patterns.
   struct Tree
   {
@@ -508,6 +655,8 @@ class Pattern {
       for (List::iterator i = list.begin(); i != list.end(); ++i)
         delete[] *i;
       list.clear();
+      tree = NULL;
+      next = ALLOC;
     }
     /// return the root of the tree.
     Node *root()
@@ -535,13 +684,12 @@ class Pattern {
   };
   /// DFA created by subset construction from regex patterns.
   struct DFA {
-    struct State : Positions {
+    struct State : Flatpos {
       typedef std::map<Char,std::pair<Char,State*> > Edges;
       State()
         :
           next(NULL),
-          left(NULL),
-          right(NULL),
+          hash(0),
           tnode(NULL),
           first(0),
           index(0),
@@ -553,15 +701,14 @@ class Pattern {
         tnode = node;
         return this;
       }
-      State *assign(Tree::Node *node, Positions& pos)
+      State *assign(Tree::Node *node, Flatpos& pos)
       {
         tnode = node;
         this->swap(pos);
         return this;
       }
       State      *next;   ///< points to next state in the list of states allocated depth-first by subset construction
-      State      *left;   ///< left pointer for O(log N) node insertion in the hash table overflow tree
-      State      *right;  ///< right pointer for O(log N) node insertion in the hash table overflow tree
+      uint64_t    hash;   ///< hash of the positions, for state lookup in the open-addressing hash table
       Tree::Node *tnode;  ///< the corresponding tree DFA node, when applicable
       Edges       edges;  ///< state transitions
       Index       first;  ///< index of this state in the opcode table, determined by the first assembly pass
@@ -599,7 +746,7 @@ class Pattern {
       return list.back()[next++].assign(node);
     }
     /// new DFA state with optional tree DFA node and positions, destroys pos.
-    State *state(Tree::Node *node, Positions& pos)
+    State *state(Tree::Node *node, Flatpos& pos)
     {
       if (next >= ALLOC)
       {
@@ -611,13 +758,235 @@ class Pattern {
     List     list; ///< block allocation list
     uint16_t next; ///< block allocation, next available slot in last block
   };
+  /// Open-addressing hash table of DFA states keyed on the hash of their positions, grows to keep the load below 1/2.
+  struct Table {
+    static const size_t INIT = 4096; ///< initial number of slots allocated by the first find(), a power of two
+    Table()
+      :
+        size(0)
+    { }
+    /// return the slot of the state with positions pos and hash h, or the empty slot to insert this state.
+    DFA::State **find(const Flatpos& pos, uint64_t h)
+    {
+      if (slot.empty())
+        slot.assign(INIT, NULL);
+      size_t mask = slot.size() - 1;
+      size_t k = h & mask;
+      // linear probing for a matching state, comparing positions only when the full hashes match
+      while (slot[k] != NULL && (slot[k]->hash != h || pos != *slot[k]))
+        k = (k + 1) & mask;
+      return &slot[k];
+    }
+    /// insert a new state with its hash set into the empty slot returned by find().
+    void insert(DFA::State **at, DFA::State *state)
+    {
+      *at = state;
+      if (2 * ++size > slot.size() - 1)
+        grow();
+    }
+    /// rehash into a table twice the size.
+    void grow()
+    {
+      std::vector<DFA::State*> larger(2 * slot.size(), NULL);
+      size_t mask = larger.size() - 1;
+      for (std::vector<DFA::State*>::const_iterator i = slot.begin(); i != slot.end(); ++i)
+      {
+        if (*i != NULL)
+        {
+          size_t k = (*i)->hash & mask;
+          while (larger[k] != NULL)
+            k = (k + 1) & mask;
+          larger[k] = *i;
+        }
+      }
+      slot.swap(larger);
+    }
+    /// remove all states, the slots are allocated again by the next find().
+    void clear()
+    {
+      std::vector<DFA::State*>().swap(slot);
+      size = 0;
+    }
+    std::vector<DFA::State*> slot; ///< slots with states or NULL, empty until the first find()
+    size_t                   size; ///< number of states in the table
+  };
+  /// NFA of a pattern compiled with option `l`, kept to construct DFA states on demand.
+  struct LazyNFA {
+    Flatpos    start;     ///< start positions
+    Flatfollow followpos; ///< followpos with sorted vectors
+    Map        modifiers; ///< modifiers
+    Map        lookahead; ///< lookahead, no lookaheads are present in a lazy NFA
+  };
+  /// Aho-Corasick automaton of a pattern of many string alternatives, used by reflex::Matcher to search the leftmost match.
+  struct AhoCorasick {
+    /// State of the automaton, interleaved to look up a state with one memory access.
+    struct State {
+      uint32_t first; ///< index of the first edge of the state in edge[], the edges of a state end at the first edge of the next state
+      uint32_t fail;  ///< failure link to the state of the longest proper suffix
+      uint32_t out;   ///< length of the longest string that ends in this state or 0
+      uint32_t depth; ///< length of the string prefix matched by this state
+    };
+    /// Edge of a state to a deeper state.
+    struct Edge {
+      uint32_t target; ///< target state
+      uint8_t  label;  ///< byte class of the edge
+    };
+    /// Returns the child state of a state on a byte class in the trie of the strings, without following failure links.
+    uint32_t child(
+        uint32_t s, ///< current state, 0 is the root
+        uint8_t  c) ///< byte class of the next byte, see map[]
+      const
+      /// @returns child state or 0 if none
+    {
+      const Edge *b = &edge[0] + state[s].first;
+      const Edge *e = &edge[0] + state[s + 1].first;
+      while (e - b > 4)
+      {
+        const Edge *m = b + (e - b) / 2;
+        if (m->label <= c)
+          b = m;
+        else
+          e = m;
+      }
+      for (; b < e; ++b)
+        if (b->label == c)
+          return b->target;
+      return 0;
+    }
+    /// Returns the next state on a byte class, follows failure links from deep states to the dense rows of shallow states.
+    uint32_t next(
+        uint32_t s, ///< current state, 0 is the root
+        uint8_t  c) ///< byte class of the next byte, see map[]
+      const
+      /// @returns next state
+    {
+      while (s >= rows)
+      {
+        uint32_t t = child(s, c);
+        if (t != 0)
+          return t;
+        s = state[s].fail;
+      }
+      return dense[s * cls + c];
+    }
+    std::vector<State>    state;    ///< states in breadth-first order, with one more state to end the edges of the last state
+    std::vector<Edge>     edge;     ///< edges of the states, sorted by byte class per state
+    std::vector<uint32_t> dense;    ///< complete transitions of the first rows states, cls per state
+    std::vector<Accept>   accept;   ///< subpattern index of the string that ends in each state or 0
+    uint32_t              rows;     ///< number of shallow states with dense transitions, at least one for the root
+    uint32_t              cls;      ///< number of byte classes
+    uint8_t               map[256]; ///< byte class of each byte, upper case bytes share the class of lower case when case insensitive
+  };
+  /// Reverse DFA of the part of the matches before a required factor string, used by reflex::Matcher to search the factor and scan backward to the start of a match.
+  struct ReverseDFA {
+    static const size_t MAXS = 255; ///< max number of states, not counting the dead state 0
+    std::string          factor;    ///< string that all matches contain, the first byte of the factor does not occur in the part before it
+    std::vector<uint8_t> next;      ///< transitions of the states on the bytes scanned backward, 256 per state, state 0 is the dead state and state 1 the start state
+    std::vector<uint8_t> accept;    ///< nonzero if a match may start after scanning backward to this state
+    bool                 part[256]; ///< true if the byte may occur in the part before the factor
+  };
+  /// Lazy DFA with a bounded cache of states constructed on demand from the NFA of a pattern compiled with option `l`.
+  class LazyDFA {
+   public:
+    static const size_t CACHE = 1024; ///< max number of cached states, the cache is flushed when full
+    /// DFA state with its transitions expanded into a jump table.
+    struct State : DFA::State {
+      State()
+        :
+          expanded(false),
+          halt(false)
+      { }
+      State *jump[256]; ///< target state for each byte or NULL, valid when expanded
+      bool   expanded;  ///< true if the transitions of this state are constructed
+      bool   halt;      ///< true if this state has no transitions, valid when expanded
+    };
+    LazyDFA()
+      :
+        pat_(NULL),
+        nfa_(NULL),
+        start_(NULL),
+        flushes_(0)
+    { }
+    /// Copy constructor, the cache is not copied.
+    LazyDFA(const LazyDFA&)
+      :
+        pat_(NULL),
+        nfa_(NULL),
+        start_(NULL),
+        flushes_(0)
+    { }
+    /// Destructor, deletes the cached states.
+    ~LazyDFA()
+    {
+      clear();
+    }
+    /// Assignment, clears the cache.
+    LazyDFA& operator=(const LazyDFA&)
+    {
+      clear();
+      pat_ = NULL;
+      nfa_ = NULL;
+      return *this;
+    }
+    /// Get the start state for the given pattern, flushes the cache when the pattern changed.
+    State *start(const Pattern *pattern)
+    {
+      if (pattern->lnf_ != nfa_)
+      {
+        clear();
+        pat_ = pattern;
+        nfa_ = pattern->lnf_;
+      }
+      if (start_ == NULL)
+        init();
+      return start_;
+    }
+    /// Get the current start state.
+    State *start() const
+    {
+      return start_;
+    }
+    /// Construct the transitions of a state when not yet expanded, returns the state, which is relocated when the cache was flushed.
+    State *expand(State *state)
+    {
+      return state->expanded ? state : construct(state);
+    }
+    /// Get the number of cached states.
+    size_t size() const
+    {
+      return all_.size();
+    }
+    /// Get the number of cache flushes.
+    size_t flushes() const
+    {
+      return flushes_;
+    }
+    /// Delete all cached states.
+    void clear();
+   private:
+    void init();
+    State *construct(State *state);
+    State *state(Flatpos& pos);
+    const Pattern      *pat_;      ///< pattern of the NFA
+    const LazyNFA      *nfa_;      ///< NFA to construct states from
+    State              *start_;    ///< start state or NULL
+    std::vector<State*> all_;      ///< cached states
+    Table               table_;    ///< cached states by positions
+    Flatfollow          lazypos_;  ///< memoized lazy followpos
+    size_t              flushes_;  ///< number of cache flushes
+  };
   /// Global modifier modes, syntax flags, and compiler options.
   struct Option {
-    Option() : b(), e(), f(), i(), m(), n(), o(), p(), q(), r(), s(), w(), x(), z() { }
+    Option() : b(), d(), e(), f(), g(), h(), i(), j(), l(), m(), n(), o(), p(), q(), r(), s(), w(), x(), z() { }
     bool                     b; ///< disable escapes in bracket lists
+    bool                     d; ///< generate a dense transition table for the reflex::Matcher engine, when applicable
     Char                     e; ///< escape character, or > 255 for none, '\\' default
     std::vector<std::string> f; ///< output to files
+    size_t                   g; ///< with option o generate binary search code and switch jump tables for states with at least g transitions, 0 to disable
+    bool                     h; ///< minimize the DFA
     bool                     i; ///< case insensitive mode, also `(?i:X)`
+    size_t                   j; ///< number of threads to construct the DFA, 0 for all hardware threads, default 1, ignored unless the library is built with WITH_PARALLEL_DFA
+    bool                     l; ///< lazy DFA: construct DFA states on demand while matching, when applicable
     bool                     m; ///< multi-line mode, also `(?m:X)`
     std::string              n; ///< pattern name (for use in generated code)
     bool                     o; ///< generate optimized FSM code for option f
@@ -713,6 +1082,14 @@ class Pattern {
       Follow&     followpos,
       const Map&  modifiers,
       const Map&  lookahead);
+  void compile_frontier(
+      DFA::State              *state,
+      const Flatfollow&        followpos,
+      std::vector<Flatfollow>& lazypos,
+      const Map&               modifiers,
+      const Map&               lookahead,
+      std::vector<Moves>&      moves) const;
+  void minimize_dfa(DFA::State *start);
   void lazy(
       const Lazyset& lazyset,
       Positions&     pos) const;
@@ -722,16 +1099,27 @@ class Pattern {
       Positions&       pos1) const;
   void greedy(Positions& pos) const;
   void trim_lazy(Positions *pos) const;
+  void trim_lazy(Flatpos *pos) const;
+  bool lazy_nfa(
+      const Positions& startpos,
+      const Follow&    followpos,
+      const Map&       modifiers,
+      const Map&       lookahead);
+  bool is_meta_at(
+      Location   loc,
+      const Map& modifiers) const;
+  bool aho_corasick();
   void compile_transition(
-      DFA::State *state,
-      Follow&     followpos,
-      const Map&  modifiers,
-      const Map&  lookahead,
-      Moves&      moves) const;
+      DFA::State       *state,
+      const Flatfollow& followpos,
+      Flatfollow&       lazypos,
+      const Map&        modifiers,
+      const Map&        lookahead,
+      Moves&            moves) const;
   void transition(
-      Moves&           moves,
-      Chars&           chars,
-      const Positions& follow) const;
+      Moves&         moves,
+      Chars&         chars,
+      const Flatpos& follow) const;
   void compile_list(
       Location   loc,
       Chars&     chars,
@@ -743,7 +1131,23 @@ class Pattern {
   void assemble(DFA::State *start);
   void compact_dfa(DFA::State *start);
   void encode_dfa(DFA::State *start);
+  void classify_dfa(const DFA::State *start);
+  void tabulate_dfa(const DFA::State *start);
   void gencode_dfa(const DFA::State *start) const;
+  void gencode_dfa_ranges(
+      const DFA::State *state,
+      Jumps&            jumps) const;
+  void gencode_dfa_jumps(
+      FILE         *fd,
+      const Jumps&  jumps) const;
+  void gencode_dfa_search(
+      FILE         *fd,
+      const Jumps&  jumps,
+      size_t        lo,
+      size_t        hi,
+      int           min,
+      int           max,
+      int           nest) const;
   void check_dfa_closure(
       const DFA::State *state,
       int               nest,
@@ -760,7 +1164,14 @@ class Pattern {
   void gen_predict_match(DFA::State *state);
   void gen_predict_match_transitions(DFA::State *state, std::map<DFA::State*,ORanges<Hash> >& states);
   void gen_predict_match_transitions(size_t level, DFA::State *state, ORanges<Hash>& labels, std::map<DFA::State*,ORanges<Hash> >& states);
+  void gen_predict_match_wide(DFA::State *start);
+  void gen_predict_nibbles(DFA::State *start);
+  bool gen_predict_nibbles_paths(DFA::State *state, size_t level, std::vector<Char>& path, std::vector<Char>& paths);
+  void reverse_dfa(const DFA::State *start);
   void write_predictor(FILE *fd) const;
+  void write_table(FILE *fd) const;
+  void gen_predictor(std::vector<Pred>& pred) const;
+  void unmap();
   void write_namespace_open(FILE* fd) const;
   void write_namespace_close(FILE* fd) const;
   size_t find_at(
@@ -819,12 +1230,12 @@ class Pattern {
       modifiers[mode].insert(from, to);
     }
   }
-  static inline uint16_t hash_pos(const Positions *pos)
+  static inline uint64_t hash_pos(const Flatpos *pos)
   {
-    uint16_t h = 0;
-    for (Positions::const_iterator i = pos->begin(); i != pos->end(); ++i)
-      h += static_cast<uint16_t>(*i ^ (*i >> 24)); // (Position(*i).iter() << 4) unique hash for up to 16 chars iterated (abc...p){iter}
-    return h;
+    uint64_t h = pos->size();
+    for (Flatpos::const_iterator i = pos->begin(); i != pos->end(); ++i)
+      h = (h ^ *i ^ (*i >> 29)) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
   }
   static inline bool valid_goto_index(Index index)
   {
@@ -935,6 +1346,18 @@ class Pattern {
   {
     return opcode & 0xFFFF;
   }
+  static inline Index table_take(Index side)
+  {
+    return side & 0xFFFFFF; // accept <= Const::AMAX (0xFDFFFF max)
+  }
+  static inline bool is_table_redo(Index side)
+  {
+    return (side & 0x40000000) != 0;
+  }
+  static inline bool is_table_halt(Index side)
+  {
+    return (side & 0x80000000) != 0;
+  }
   static inline Char lowercase(Char c)
   {
     return static_cast<unsigned char>(c | 0x20);
@@ -966,12 +1389,25 @@ class Pattern {
   const Opcode         *opc_; ///< points to the opcode table
   Index                 nop_; ///< number of opcodes generated
   FSM                   fsm_; ///< function pointer to FSM code
+  Index                *tbl_; ///< dense transition table with rows [side, next[0], ..., next[ncl_-1]] or NULL
+  Index                 nrw_; ///< number of rows (states) of the dense transition table
+  Index                 ncl_; ///< number of byte classes of the DFA when computed with option d, h or o, or 0
+  uint8_t               bcl_[256]; ///< byte equivalence class of each byte, indexes the dense transition table rows and the switch jump tables of FSM code
+  LazyNFA              *lnf_; ///< NFA kept to construct DFA states on demand with option `l`, or NULL
+  AhoCorasick          *aho_; ///< Aho-Corasick automaton of a pattern of more than 16 * Const::NMAX string alternatives, or NULL
+  ReverseDFA           *rev_; ///< reverse DFA and required factor string of a pattern without a prefix, or NULL
+  const void           *map_; ///< memory-mapped compiled pattern file loaded by load_mapped(), or NULL
+  size_t                mms_; ///< size of the memory-mapped compiled pattern file
   size_t                len_; ///< prefix length of pre_[], less or equal to 255
   size_t                min_; ///< patterns after the prefix are at least this long but no more than 8
   char                  pre_[256];         ///< pattern prefix, shorter or equal to 255 bytes
   Pred                  bit_[256];         ///< bitap array
   Pred                  pmh_[Const::HASH]; ///< predict-match hash array
   Pred                  pma_[Const::HASH]; ///< predict-match array
+  size_t                nbp_; ///< number of leading bytes 1 to 3 of matches predicted by the nibble tables nib_[], 0 if not used
+  Pred                  nib_[3][32];       ///< per leading byte of a match, bucket masks of the 16 low nibbles and 16 high nibbles of the literals
+  size_t                wbl_; ///< patterns are at least this long, 9 to 64, when predicted by the 64-bit bitap array wbp_[], 0 if not used
+  uint64_t              wbp_[256];         ///< 64-bit bitap array of the first wbl_ bytes of patterns without a prefix
   float                 pms_; ///< ms elapsed time to parse regex
   float                 vms_; ///< ms elapsed time to compile DFA vertices
   float                 ems_; ///< ms elapsed time to compile DFA edges
@@ -0,0 +1,173 @@
+/******************************************************************************\
+* Copyright (c) 2016, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      readahead.h
+@brief     C++11 read-ahead stream buffer to read input in a background thread
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2016-2020, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#ifndef REFLEX_READAHEAD_H
+#define REFLEX_READAHEAD_H
+
+#include <reflex/input.h>
+#include <condition_variable>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace reflex {
+
+/// Read-ahead stream buffer for reflex::Input that reads the input in a background thread into a ring of blocks, derived from std::streambuf.
+/**
+A background thread reads the input into a ring of fixed-size blocks ahead of
+the matcher, which overlaps I/O with pattern matching when reading from slow
+file systems and pipes.  Each block read is handed to the stream buffer's get
+area without copying.  The input is read with reflex::Input::get(), which
+normalizes UTF-16/32 and code page file encodings to UTF-8 in the background
+thread.
+
+A block is handed over when it is full or when the input ends, which makes
+read-ahead unsuitable for interactive input.  The destructor stops the reader
+thread and waits for its last read to return.
+
+Example:
+
+    reflex::Input input(fopen("large.txt", "r"));
+    if (input.file() == NULL)
+      abort();
+    reflex::ReadAheadBuffer buffer(input);  // 4 blocks of 64KB
+    std::istream stream(&buffer);
+    reflex::Matcher matcher("\\w+", stream);
+    while (matcher.find() != 0)
+      std::cout << matcher.text() << std::endl;
+*/
+class ReadAheadBuffer : public std::streambuf {
+ public:
+  /// Default number of blocks in the ring.
+  static const size_t BLOCKS = 4;
+  /// Default block size.
+  static const size_t SIZE = 65536;
+  /// Construct a read-ahead stream buffer for the given input and start reading the input in a background thread.
+  ReadAheadBuffer(
+      const Input& input,           ///< input to read ahead
+      size_t       blocks = BLOCKS, ///< number of blocks in the ring, at least 2
+      size_t       size = SIZE)     ///< block size, nonzero
+    :
+      input_(input),
+      num_(blocks >= 2 ? blocks : 2),
+      size_(size > 0 ? size : SIZE),
+      buf_(num_ * size_),
+      len_(num_, 0),
+      head_(0),
+      full_(0),
+      cur_(false),
+      stop_(false)
+  {
+    thread_ = std::thread(&ReadAheadBuffer::read, this);
+  }
+  /// Stop reading and wait for the reader thread to finish.
+  virtual ~ReadAheadBuffer()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      stop_ = true;
+    }
+    free_cv_.notify_one();
+    thread_.join();
+  }
+ protected:
+  /// Release the block consumed and wait for the next block read ahead.
+  virtual int_type underflow()
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (cur_)
+    {
+      // release the block consumed to the reader thread
+      head_ = (head_ + 1) % num_;
+      --full_;
+      cur_ = false;
+      free_cv_.notify_one();
+    }
+    while (full_ == 0)
+      full_cv_.wait(lock);
+    size_t len = len_[head_];
+    if (len == 0)
+      return traits_type::eof(); // keep the empty block that marks the end of the input
+    cur_ = true;
+    char *b = &buf_[head_ * size_];
+    setg(b, b, b + len);
+    return traits_type::to_int_type(*b);
+  }
+  /// Reader thread: read the input into free blocks until the end of the input is reached or until stopped.
+  void read()
+  {
+    while (true)
+    {
+      size_t w;
+      {
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (!stop_ && full_ == num_)
+          free_cv_.wait(lock);
+        if (stop_)
+          return;
+        w = (head_ + full_) % num_;
+      }
+      // only the reader thread accesses free block w
+      size_t len = input_.get(&buf_[w * size_], size_);
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        len_[w] = len;
+        ++full_;
+      }
+      full_cv_.notify_one();
+      if (len == 0)
+        return;
+    }
+  }
+  Input                   input_;   ///< input read by the reader thread
+  size_t                  num_;     ///< number of blocks in the ring
+  size_t                  size_;    ///< block size
+  std::vector<char>       buf_;     ///< ring of num_ blocks of size_ bytes
+  std::vector<size_t>     len_;     ///< number of bytes read into each block, zero at the end of the input
+  size_t                  head_;    ///< index of the block consumed or to consume next
+  size_t                  full_;    ///< number of blocks read from head_ on
+  bool                    cur_;     ///< true if block head_ is the get area
+  bool                    stop_;    ///< true to stop the reader thread
+  std::mutex              mtx_;     ///< protects head_, full_, len_, cur_ and stop_
+  std::condition_variable full_cv_; ///< signals a block read
+  std::condition_variable free_cv_; ///< signals a block released or stop
+  std::thread             thread_;  ///< reader thread
+};
+
+} // namespace reflex
+
+#endif
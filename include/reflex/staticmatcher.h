@@ -0,0 +1,147 @@
+/******************************************************************************\
+* Copyright (c) 2016, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      staticmatcher.h
+@brief     RE/flex matcher engine with static dense transition tables of generated patterns
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2016-2020, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#ifndef REFLEX_STATICMATCHER_H
+#define REFLEX_STATICMATCHER_H
+
+#include <reflex/matcher.h>
+
+namespace reflex {
+
+/// RE/flex matcher engine that matches with the static dense transition tables T of patterns generated by reflex option `−−static`.
+/**
+The tables T are a class with a static member function that returns the dense
+transition table and byte classes of a pattern, given the pattern's opcode
+table, or NULL when T has no table for the pattern:
+
+    struct T {
+      static const reflex::Pattern::Index *table(const reflex::Pattern::Opcode *code, const uint8_t*& bcl);
+    };
+
+The `reflex_tables_NAME` classes generated with the opcode tables of patterns
+compiled with options `d` and `f=file.cpp` are such tables.  This matcher
+calls T::table() once when its pattern changes and keeps the table for all
+matches with the pattern, which are made with one indexed load per input byte.
+Patterns for which T has no table are matched as usual by the reflex::Matcher
+engine, for example patterns with anchors and lookaheads, for which no dense
+transition table is generated.
+
+Matches are still made through the virtual AbstractMatcher::match() method,
+like all other matcher engines, and the tables are read through pointers.  Use
+scan_batch() to scan many tokens with a single call.
+
+Example:
+
+    reflex::Pattern pattern(reflex_code_FSM);
+    reflex::StaticMatcher<reflex_tables_FSM> matcher(pattern, "input");
+    while (matcher.scan() != 0)
+      std::cout << matcher.text() << std::endl;
+*/
+template<typename T>
+class StaticMatcher : public Matcher {
+ public:
+  /// Default constructor.
+  StaticMatcher()
+    :
+      Matcher(),
+      opc_(NULL),
+      stb_(NULL),
+      scl_(NULL)
+  { }
+  /// Construct matcher engine from a pattern or a string regex, and an input character sequence.
+  template<typename P> /// @tparam <P> a reflex::Pattern or a string regex 
+  StaticMatcher(
+      const P     *pattern,         ///< points to a reflex::Pattern or a string regex for this matcher
+      const Input& input = Input(), ///< input character sequence for this matcher
+      const char  *opt = NULL)      ///< option string of the form `(A|N|T(=[[:digit:]])?|;)*`
+    :
+      Matcher(pattern, input, opt),
+      opc_(NULL),
+      stb_(NULL),
+      scl_(NULL)
+  { }
+  /// Construct matcher engine from a pattern or a string regex, and an input character sequence.
+  template<typename P> /// @tparam <P> a reflex::Pattern or a string regex 
+  StaticMatcher(
+      const P&     pattern,          ///< a reflex::Pattern or a string regex for this matcher
+      const Input& input = Input(),  ///< input character sequence for this matcher
+      const char   *opt = NULL)      ///< option string of the form `(A|N|T(=[[:digit:]])?|;)*`
+    :
+      Matcher(pattern, input, opt),
+      opc_(NULL),
+      stb_(NULL),
+      scl_(NULL)
+  { }
+  /// Polymorphic cloning.
+  virtual StaticMatcher *clone()
+  {
+    return new StaticMatcher(*this);
+  }
+  /// Scan the input for up to max tokens stored in out with the static dense tables T, returns the number of tokens stored.
+  size_t scan_batch(
+      Token *out,           ///< array of at least max tokens
+      size_t max,           ///< max number of tokens to scan
+      bool   lines = false) ///< also store the line number of each token
+    /// @returns number of tokens stored in out
+  {
+    tables();
+    return scan_batch_tables(out, max, lines, stb_, scl_);
+  }
+ protected:
+  /// Returns true if input matched the pattern using method Const::SCAN, Const::FIND, Const::SPLIT, or Const::MATCH.
+  virtual size_t match(Method method) ///< Const::SCAN, Const::FIND, Const::SPLIT, or Const::MATCH
+    /// @returns nonzero if input matched the pattern
+  {
+    tables();
+    return match_tables(method, stb_, scl_);
+  }
+  /// Get the static dense table of T for the opcode table of the pattern, calls T::table() only when the pattern changed.
+  void tables()
+  {
+    if (pat_->opc_ != opc_)
+    {
+      opc_ = pat_->opc_;
+      stb_ = T::table(opc_, scl_);
+    }
+  }
+  const Pattern::Opcode *opc_; ///< opcode table of the pattern for which stb_ was returned by T::table()
+  const Pattern::Index  *stb_; ///< static dense transition table of T for opc_ or NULL
+  const uint8_t         *scl_; ///< byte equivalence classes of stb_
+};
+
+} // namespace reflex
+
+#endif
@@ -0,0 +1,280 @@
+/******************************************************************************\
+* Copyright (c) 2016, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      decompress.cpp
+@brief     Decompressing stream buffer for gzip, zstd and lz4 compressed input
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2016-2020, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+
+#include <reflex/decompress.h>
+
+#if defined(HAVE_LIBZ)
+# include <zlib.h>
+#endif
+#if defined(HAVE_LIBZSTD)
+# include <zstd.h>
+#endif
+#if defined(HAVE_LIBLZ4)
+# include <lz4frame.h>
+#endif
+
+namespace reflex {
+
+bool DecompressBuffer::supported(compression_type zip)
+{
+  switch (zip)
+  {
+    case compression::plain:
+      return true;
+#if defined(HAVE_LIBZ)
+    case compression::gzip:
+      return true;
+#endif
+#if defined(HAVE_LIBZSTD)
+    case compression::zstd:
+      return true;
+#endif
+#if defined(HAVE_LIBLZ4)
+    case compression::lz4:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+void DecompressBuffer::init()
+{
+  const unsigned char *b = reinterpret_cast<const unsigned char*>(&in_[0]);
+#if defined(HAVE_LIBZ)
+  if (len_ >= 2 && b[0] == 0x1F && b[1] == 0x8B)
+  {
+    z_stream *zstrm = new z_stream;
+    std::memset(zstrm, 0, sizeof(z_stream));
+    if (inflateInit2(zstrm, 15 + 16) == Z_OK)
+    {
+      dec_ = zstrm;
+      zip_ = compression::gzip;
+    }
+    else
+    {
+      delete zstrm;
+    }
+  }
+#endif
+#if defined(HAVE_LIBZSTD)
+  if (len_ >= 4 && b[0] == 0x28 && b[1] == 0xB5 && b[2] == 0x2F && b[3] == 0xFD)
+  {
+    ZSTD_DStream *zstd = ZSTD_createDStream();
+    if (zstd != NULL)
+    {
+      dec_ = zstd;
+      zip_ = compression::zstd;
+    }
+  }
+#endif
+#if defined(HAVE_LIBLZ4)
+  if (len_ >= 4 && b[0] == 0x04 && b[1] == 0x22 && b[2] == 0x4D && b[3] == 0x18)
+  {
+    LZ4F_dctx *lz4 = NULL;
+    if (!LZ4F_isError(LZ4F_createDecompressionContext(&lz4, LZ4F_VERSION)))
+    {
+      dec_ = lz4;
+      zip_ = compression::lz4;
+    }
+  }
+#endif
+  (void)b;
+}
+
+void DecompressBuffer::done()
+{
+  switch (zip_)
+  {
+#if defined(HAVE_LIBZ)
+    case compression::gzip:
+      inflateEnd(static_cast<z_stream*>(dec_));
+      delete static_cast<z_stream*>(dec_);
+      break;
+#endif
+#if defined(HAVE_LIBZSTD)
+    case compression::zstd:
+      ZSTD_freeDStream(static_cast<ZSTD_DStream*>(dec_));
+      break;
+#endif
+#if defined(HAVE_LIBLZ4)
+    case compression::lz4:
+      LZ4F_freeDecompressionContext(static_cast<LZ4F_dctx*>(dec_));
+      break;
+#endif
+    default:
+      break;
+  }
+  dec_ = NULL;
+}
+
+size_t DecompressBuffer::decompress(char *s, size_t n)
+{
+  while (!end_)
+  {
+    if (pos_ >= len_ && zip_ != compression::plain)
+      fill();
+    size_t avail = len_ - pos_;
+    size_t used = 0;
+    size_t k = 0;
+    switch (zip_)
+    {
+#if defined(HAVE_LIBZ)
+      case compression::gzip:
+      {
+        z_stream *zstrm = static_cast<z_stream*>(dec_);
+        zstrm->next_in = reinterpret_cast<Bytef*>(&in_[pos_]);
+        zstrm->avail_in = static_cast<uInt>(avail);
+        zstrm->next_out = reinterpret_cast<Bytef*>(s);
+        zstrm->avail_out = static_cast<uInt>(n);
+        int ret = inflate(zstrm, Z_NO_FLUSH);
+        used = avail - zstrm->avail_in;
+        pos_ += used;
+        k = n - zstrm->avail_out;
+        if (ret == Z_STREAM_END)
+        {
+          // the gzip member ended, decompress the next member if any
+          fin_ = true;
+          if (len_ - pos_ < 2)
+            fill();
+          if (len_ - pos_ >= 2 && in_[pos_] == '\x1F' && in_[pos_ + 1] == '\x8B')
+            inflateReset(zstrm);
+          else
+            end_ = true;
+        }
+        else if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+          err_ = true;
+          end_ = true;
+        }
+        else if (used > 0 || k > 0)
+        {
+          fin_ = false;
+        }
+        break;
+      }
+#endif
+#if defined(HAVE_LIBZSTD)
+      case compression::zstd:
+      {
+        ZSTD_inBuffer in = { &in_[pos_], avail, 0 };
+        ZSTD_outBuffer out = { s, n, 0 };
+        size_t ret = ZSTD_decompressStream(static_cast<ZSTD_DStream*>(dec_), &out, &in);
+        used = in.pos;
+        pos_ += used;
+        k = out.pos;
+        if (ZSTD_isError(ret))
+        {
+          err_ = true;
+          end_ = true;
+        }
+        else if (used > 0 || k > 0)
+        {
+          fin_ = ret == 0;
+        }
+        break;
+      }
+#endif
+#if defined(HAVE_LIBLZ4)
+      case compression::lz4:
+      {
+        size_t src = avail;
+        size_t dst = n;
+        size_t ret = LZ4F_decompress(static_cast<LZ4F_dctx*>(dec_), s, &dst, &in_[pos_], &src, NULL);
+        used = src;
+        pos_ += used;
+        k = dst;
+        if (LZ4F_isError(ret))
+        {
+          err_ = true;
+          end_ = true;
+        }
+        else if (used > 0 || k > 0)
+        {
+          fin_ = ret == 0;
+        }
+        break;
+      }
+#endif
+      default:
+        if (avail > 0)
+        {
+          // copy the input read to detect the compression format
+          k = std::min(n, avail);
+          std::memcpy(s, &in_[pos_], k);
+          pos_ += k;
+        }
+        else if (!eof_)
+        {
+          // read uncompressed input directly into s
+          k = ::fread(s, 1, n, file_);
+          if (k == 0)
+            eof_ = true;
+        }
+        used = k;
+        break;
+    }
+    if (k > 0)
+      return k;
+    if (used == 0 && !end_)
+    {
+      if (pos_ >= len_ && eof_)
+      {
+        // the input ended, a compressed stream should end with a complete gzip member or frame
+        if (!fin_)
+          err_ = true;
+        end_ = true;
+      }
+      else if (eof_ || (pos_ == 0 && len_ == SIZE))
+      {
+        // no progress with the input available
+        err_ = true;
+        end_ = true;
+      }
+      else
+      {
+        fill();
+      }
+    }
+  }
+  return 0;
+}
+
+} // namespace reflex
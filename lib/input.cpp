@@ -39,16 +39,35 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2)
+# include <emmintrin.h>
+#elif defined(HAVE_NEON)
+# include <arm_neon.h>
+#endif
+
 #if (defined(__WIN32__) || defined(_WIN32) || defined(WIN32) || defined(_WIN64) || defined(__BORLANDC__)) && !defined(__CYGWIN__) && !defined(__MINGW32__) && !defined(__MINGW64__)
 # define off_t __int64
 # define ftello _ftelli64
 # define fseeko _fseeki64
 #else
 # include <unistd.h> // off_t, fstat()
+# ifndef WITH_NO_MMAP
+#  include <sys/mman.h> // mmap(), madvise(), munmap()
+#  define REFLEX_WITH_MMAP
+# endif
 #endif
 
 namespace reflex {
 
+/// Size of the staging buffer of Input::file_get_utf16() and Input::file_get_utf32() to read blocks of UTF-16/32 code units.
+static const size_t UTF_STAGE = 4096;
+
+/// Max length of a UTF-8 sequence stored by utf8(), including REFLEX_NONCHAR_UTF8.
+static const size_t UTF8_MAX = 6;
+
+/// Min buffer size to convert 8-bit code page characters in blocks with Input::file_get_page(), which populates a table of 256 UTF-8 sequences.
+static const size_t PAGE_MIN = 256;
+
 static const unsigned short codepages[38][256] =
 {
   // DOS CP 437 to Unicode
@@ -747,6 +766,12 @@ size_t Input::file_get(char *s, size_t n)
   switch (utfx_)
   {
     case file_encoding::utf16be:
+      if (n >= UTF8_MAX)
+      {
+        size_t k = file_get_utf16(t, n, true);
+        t += k;
+        n -= k;
+      }
       while (n > 0 && ::fread(buf, 2, 1, file_) == 1)
       {
         int c = buf[0] << 8 | buf[1];
@@ -784,6 +809,12 @@ size_t Input::file_get(char *s, size_t n)
       }
       return t - s;
     case file_encoding::utf16le:
+      if (n >= UTF8_MAX)
+      {
+        size_t k = file_get_utf16(t, n, false);
+        t += k;
+        n -= k;
+      }
       while (n > 0 && ::fread(buf, 2, 1, file_) == 1)
       {
         int c = buf[0] | buf[1] << 8;
@@ -821,9 +852,15 @@ size_t Input::file_get(char *s, size_t n)
       }
       return t - s;
     case file_encoding::utf32be:
+      if (n >= UTF8_MAX)
+      {
+        size_t k = file_get_utf32(t, n, true);
+        t += k;
+        n -= k;
+      }
       while (n > 0 && ::fread(buf, 4, 1, file_) == 1)
       {
-        int c = buf[0] << 24 | buf[1] << 16 | buf[2] << 8 | buf[3];
+        int c = buf[0] < 0x80 ? buf[0] << 24 | buf[1] << 16 | buf[2] << 8 | buf[3] : REFLEX_NONCHAR;
         if (c < 0x80)
         {
           *t++ = static_cast<char>(c);
@@ -850,9 +887,15 @@ size_t Input::file_get(char *s, size_t n)
       }
       return t - s;
     case file_encoding::utf32le:
+      if (n >= UTF8_MAX)
+      {
+        size_t k = file_get_utf32(t, n, false);
+        t += k;
+        n -= k;
+      }
       while (n > 0 && ::fread(buf, 4, 1, file_) == 1)
       {
-        int c = buf[0] | buf[1] << 8 | buf[2] << 16 | buf[3] << 24;
+        int c = buf[3] < 0x80 ? buf[0] | buf[1] << 8 | buf[2] << 16 | buf[3] << 24 : REFLEX_NONCHAR;
         if (c < 0x80)
         {
           *t++ = static_cast<char>(c);
@@ -879,6 +922,12 @@ size_t Input::file_get(char *s, size_t n)
       }
       return t - s;
     case file_encoding::latin:
+      if (n >= PAGE_MIN)
+      {
+        size_t k = file_get_page(t, n, NULL);
+        t += k;
+        n -= k;
+      }
       while (n > 0 && ::fread(t, 1, 1, file_) == 1)
       {
         int c = static_cast<unsigned char>(*t);
@@ -937,6 +986,12 @@ size_t Input::file_get(char *s, size_t n)
     case file_encoding::koi8_u:
     case file_encoding::koi8_ru:
     case file_encoding::custom:
+      if (n >= PAGE_MIN)
+      {
+        size_t k = file_get_page(t, n, page_);
+        t += k;
+        n -= k;
+      }
       while (n > 0 && ::fread(t, 1, 1, file_) == 1)
       {
         int c = page_[static_cast<unsigned char>(*t)];
@@ -970,6 +1025,232 @@ size_t Input::file_get(char *s, size_t n)
   }
 }
 
+size_t Input::file_get_utf16(char *s, size_t n, bool be)
+{
+  char *t = s;
+  unsigned char buf[UTF_STAGE + 2]; // room for the low surrogate of a pair split at the end of a block
+  // each code unit converts to at most UTF8_MAX bytes, including a surrogate pair of two units split at the end of a block
+  while (n >= UTF8_MAX)
+  {
+    size_t k = n / UTF8_MAX;
+    if (k > UTF_STAGE / 2)
+      k = UTF_STAGE / 2;
+    size_t r = ::fread(buf, 2, k, file_);
+    const unsigned char *b = buf;
+    const unsigned char *e = buf + 2 * r;
+    char *u = t;
+    while (b < e)
+    {
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2)
+      // ASCII fast path: convert 8 ASCII code units at a time
+      const __m128i vmask = _mm_set1_epi16(static_cast<short>(0xFF80));
+      const __m128i vzero = _mm_setzero_si128();
+      while (b + 16 <= e)
+      {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        if (be)
+          v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, vmask), vzero)) != 0xFFFF)
+          break;
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(t), _mm_packus_epi16(v, v));
+        t += 8;
+        b += 16;
+      }
+      if (b >= e)
+        break;
+#elif defined(HAVE_NEON) && defined(__aarch64__)
+      // ASCII fast path: convert 8 ASCII code units at a time
+      while (b + 16 <= e)
+      {
+        uint8x16_t v = vld1q_u8(b);
+        if (be)
+          v = vrev16q_u8(v);
+        uint16x8_t w = vreinterpretq_u16_u8(v);
+        if (vmaxvq_u16(w) >= 0x80)
+          break;
+        vst1_u8(reinterpret_cast<uint8_t*>(t), vmovn_u16(w));
+        t += 8;
+        b += 16;
+      }
+      if (b >= e)
+        break;
+#endif
+      int c = be ? b[0] << 8 | b[1] : b[0] | b[1] << 8;
+      b += 2;
+      if (c < 0x80)
+      {
+        *t++ = static_cast<char>(c);
+        continue;
+      }
+      if (c >= 0xD800 && c < 0xE000)
+      {
+        // UTF-16 surrogate pair, read the low surrogate when the pair is split at the end of the block
+        if (c < 0xDC00 && (b < e || ::fread(buf + 2 * r, 2, 1, file_) == 1))
+        {
+          if (b == e)
+            e += 2;
+          int d = be ? b[0] << 8 | b[1] : b[0] | b[1] << 8;
+          b += 2;
+          if ((d & 0xFC00) == 0xDC00)
+            c = 0x010000 - 0xDC00 + ((c - 0xD800) << 10) + d;
+          else
+            c = REFLEX_NONCHAR;
+        }
+        else
+        {
+          c = REFLEX_NONCHAR;
+        }
+      }
+      t += utf8(c, t);
+    }
+    n -= t - u;
+    if (r < k)
+      break;
+  }
+  return t - s;
+}
+
+size_t Input::file_get_utf32(char *s, size_t n, bool be)
+{
+  char *t = s;
+  unsigned char buf[UTF_STAGE];
+  // each code unit converts to at most UTF8_MAX bytes
+  while (n >= UTF8_MAX)
+  {
+    size_t k = n / UTF8_MAX;
+    if (k > UTF_STAGE / 4)
+      k = UTF_STAGE / 4;
+    size_t r = ::fread(buf, 4, k, file_);
+    const unsigned char *b = buf;
+    const unsigned char *e = buf + 4 * r;
+    char *u = t;
+    while (b < e)
+    {
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2)
+      // ASCII fast path: convert 4 ASCII code units at a time
+      const __m128i vmask = _mm_set1_epi32(be ? static_cast<int>(0x80FFFFFF) : static_cast<int>(0xFFFFFF80));
+      const __m128i vzero = _mm_setzero_si128();
+      while (b + 16 <= e)
+      {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, vmask), vzero)) != 0xFFFF)
+          break;
+        if (be)
+          v = _mm_srli_epi32(v, 24);
+        v = _mm_packs_epi32(v, v);
+        int w = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+        std::memcpy(t, &w, 4);
+        t += 4;
+        b += 16;
+      }
+      if (b >= e)
+        break;
+#elif defined(HAVE_NEON) && defined(__aarch64__)
+      // ASCII fast path: convert 4 ASCII code units at a time
+      while (b + 16 <= e)
+      {
+        uint8x16_t v = vld1q_u8(b);
+        if (be)
+          v = vrev32q_u8(v);
+        uint32x4_t w = vreinterpretq_u32_u8(v);
+        if (vmaxvq_u32(w) >= 0x80)
+          break;
+        uint16x4_t h = vmovn_u32(w);
+        uint32_t a = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(h, h))), 0);
+        std::memcpy(t, &a, 4);
+        t += 4;
+        b += 16;
+      }
+      if (b >= e)
+        break;
+#endif
+      int c;
+      if (be)
+        c = b[0] < 0x80 ? b[0] << 24 | b[1] << 16 | b[2] << 8 | b[3] : REFLEX_NONCHAR;
+      else
+        c = b[3] < 0x80 ? b[0] | b[1] << 8 | b[2] << 16 | b[3] << 24 : REFLEX_NONCHAR;
+      b += 4;
+      if (c < 0x80)
+        *t++ = static_cast<char>(c);
+      else
+        t += utf8(c, t);
+    }
+    n -= t - u;
+    if (r < k)
+      break;
+  }
+  return t - s;
+}
+
+size_t Input::file_get_page(char *s, size_t n, const unsigned short *page)
+{
+  char *t = s;
+  unsigned char buf[UTF_STAGE];
+  // UTF-8 sequences of the 256 characters of the code page, at most 3 bytes each with the length stored in the 4th byte
+  unsigned char utf[256][4];
+  // true if the code page maps 0x00 to 0x7F to ASCII, to pass ASCII through unchanged
+  bool ascii = true;
+  for (int i = 0; i < 256; ++i)
+  {
+    int c = page != NULL ? page[i] : i;
+    utf[i][3] = static_cast<unsigned char>(utf8(c, reinterpret_cast<char*>(utf[i])));
+    if (i < 0x80 && c != i)
+      ascii = false;
+  }
+  // each 8-bit character converts to at most 3 bytes stored with a 4 byte copy, so k characters fit in 3k+1 bytes
+  while (n >= 4)
+  {
+    size_t k = (n - 1) / 3;
+    if (k > UTF_STAGE)
+      k = UTF_STAGE;
+    size_t r = ::fread(buf, 1, k, file_);
+    const unsigned char *b = buf;
+    const unsigned char *e = buf + r;
+    char *u = t;
+    while (b < e)
+    {
+      if (ascii)
+      {
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2)
+        // ASCII fast path: pass 16 ASCII characters through at a time
+        while (b + 16 <= e)
+        {
+          __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+          if (_mm_movemask_epi8(v) != 0)
+            break;
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(t), v);
+          t += 16;
+          b += 16;
+        }
+#elif defined(HAVE_NEON) && defined(__aarch64__)
+        // ASCII fast path: pass 16 ASCII characters through at a time
+        while (b + 16 <= e)
+        {
+          uint8x16_t v = vld1q_u8(b);
+          if (vmaxvq_u8(v) >= 0x80)
+            break;
+          vst1q_u8(reinterpret_cast<uint8_t*>(t), v);
+          t += 16;
+          b += 16;
+        }
+#endif
+      }
+      // convert the next (up to) 16 characters with the table
+      const unsigned char *f = e - b > 16 ? b + 16 : e;
+      while (b < f)
+      {
+        const unsigned char *c = utf[*b++];
+        std::memcpy(t, c, 4);
+        t += c[3];
+      }
+    }
+    n -= t - u;
+    if (r < k)
+      break;
+  }
+  return t - s;
+}
+
 void Input::wstring_size()
 {
   unsigned int c;
@@ -1093,7 +1374,7 @@ void Input::file_size()
       case file_encoding::utf32be:
         while (::fread(buf, 4, 1, file_) == 1)
         {
-          int c = buf[0] << 24 | buf[1] << 16 | buf[2] << 8 | buf[3];
+          int c = buf[0] < 0x80 ? buf[0] << 24 | buf[1] << 16 | buf[2] << 8 | buf[3] : REFLEX_NONCHAR;
 #ifndef WITH_UTF8_UNRESTRICTED
           if (c > 0x10FFFF)
             c = REFLEX_NONCHAR;
@@ -1104,7 +1385,7 @@ void Input::file_size()
       case file_encoding::utf32le:
         while (::fread(buf, 4, 1, file_) == 1)
         {
-          int c = buf[0] | buf[1] << 8 | buf[2] << 16 | buf[3] << 24;
+          int c = buf[3] < 0x80 ? buf[0] | buf[1] << 8 | buf[2] << 16 | buf[3] << 24 : REFLEX_NONCHAR;
 #ifndef WITH_UTF8_UNRESTRICTED
           if (c > 0x10FFFF)
             c = REFLEX_NONCHAR;
@@ -1139,6 +1420,14 @@ void Input::istream_size()
 
 void Input::file_encoding(unsigned short enc, const unsigned short *page)
 {
+  // decode the rest of a memory-mapped file with its FILE* from the current position in the mapped data
+  if (mapped() && enc != file_encoding::plain && enc != file_encoding::utf8 && mapped_->file() != NULL && ::fseeko(mapped_->file(), static_cast<off_t>(mapped_->offset(cstring_)), SEEK_SET) == 0)
+  {
+    file_ = mapped_->file();
+    cstring_ = NULL;
+    size_ = 0;
+    mapped_ = NULL;
+  }
   if (file_ && utfx_ != enc)
   {
     if (utfx_ == file_encoding::plain && uidx_ < sizeof(utf8_))
@@ -1323,4 +1612,64 @@ void Input::file_encoding(unsigned short enc, const unsigned short *page)
   }
 }
 
+void MappedFile::map()
+{
+#ifdef REFLEX_WITH_MMAP
+  if (file_ == NULL)
+    return;
+  // map regular files only, pipes and TTYs are read with the FILE*
+  struct stat st;
+  if (::fstat(::fileno(file_), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+    return;
+  off_t k = ftello(file_);
+  if (k < 0 || k >= st.st_size)
+    return;
+  len_ = static_cast<size_t>(st.st_size);
+  if (static_cast<off_t>(len_) != st.st_size)
+    return;
+  void *base = ::mmap(NULL, len_, PROT_READ, MAP_PRIVATE, ::fileno(file_), 0);
+  if (base == MAP_FAILED)
+    return;
+  base_ = base;
+#ifdef MADV_SEQUENTIAL
+  ::madvise(base_, len_, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_HUGEPAGE
+  ::madvise(base_, len_, MADV_HUGEPAGE);
+#endif
+  const char *data = static_cast<const char*>(base_) + k;
+  size_t size = len_ - static_cast<size_t>(k);
+  // skip UTF-8 BOM, UTF-16 and UTF-32 with a BOM are read with the FILE* to convert to UTF-8
+  if (size >= 3 && data[0] == '\xef' && data[1] == '\xbb' && data[2] == '\xbf')
+  {
+    data += 3;
+    size -= 3;
+  }
+  else if (size >= 2 && ((data[0] == '\xfe' && data[1] == '\xff') || (data[0] == '\xff' && data[1] == '\xfe')))
+  {
+    unmap();
+    return;
+  }
+  else if (size >= 4 && data[0] == '\0' && data[1] == '\0' && data[2] == '\xfe' && data[3] == '\xff')
+  {
+    unmap();
+    return;
+  }
+  data_ = data;
+  size_ = size;
+#endif
+}
+
+void MappedFile::unmap()
+{
+#ifdef REFLEX_WITH_MMAP
+  if (base_ != NULL)
+    ::munmap(base_, len_);
+#endif
+  base_ = NULL;
+  len_ = 0;
+  data_ = NULL;
+  size_ = 0;
+}
+
 } // namespace reflex
@@ -42,8 +42,19 @@
 # include <immintrin.h>
 #elif defined(HAVE_SSE2)
 # include <emmintrin.h>
+# if defined(__AVX2__)
+#  include <immintrin.h>
+# elif defined(__SSSE3__)
+#  include <tmmintrin.h>
+# endif
 #elif defined(HAVE_NEON)
 # include <arm_neon.h>
+# if defined(__ARM_FEATURE_SVE)
+#  include <arm_sve.h>
+# endif
+# if defined(__linux__)
+#  include <sys/auxv.h>
+# endif
 #endif
 
 #if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2)
@@ -58,7 +69,7 @@
 
 namespace reflex {
 
-#if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2)
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2) || defined(HAVE_NEON)
 
 #ifdef _MSC_VER
 #pragma intrinsic(_BitScanForward)
@@ -77,6 +88,32 @@ inline uint32_t ctzl(uint64_t x)
   return r;
 }
 #endif
+#pragma intrinsic(_BitScanReverse)
+inline uint32_t clz(uint32_t x)
+{
+  unsigned long r;
+  _BitScanReverse(&r, x);
+  return 31 - r;
+}
+#ifdef _WIN64
+#pragma intrinsic(_BitScanReverse64)
+inline uint32_t clzl(uint64_t x)
+{
+  unsigned long r;
+  _BitScanReverse64(&r, x);
+  return 63 - r;
+}
+#endif
+inline uint32_t popcount(uint32_t x)
+{
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  return (((x + (x >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+inline uint32_t popcountl(uint64_t x)
+{
+  return popcount(static_cast<uint32_t>(x)) + popcount(static_cast<uint32_t>(x >> 32));
+}
 #else
 inline uint32_t ctz(uint32_t x)
 {
@@ -84,10 +121,30 @@ inline uint32_t ctz(uint32_t x)
 }
 inline uint32_t ctzl(uint64_t x)
 {
-  return __builtin_ctzl(x);
+  return __builtin_ctzll(x);
+}
+inline uint32_t clz(uint32_t x)
+{
+  return __builtin_clz(x);
+}
+inline uint32_t clzl(uint64_t x)
+{
+  return __builtin_clzll(x);
+}
+inline uint32_t popcount(uint32_t x)
+{
+  return __builtin_popcount(x);
 }
+inline uint32_t popcountl(uint64_t x)
+{
+  return __builtin_popcountll(x);
+}
+#endif
+
 #endif
 
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2)
+
 uint64_t Matcher::get_HW()
 {
   int CPUInfo1[4] = { -1, 0, 0, 0 };
@@ -102,6 +159,22 @@ uint64_t Matcher::get_HW()
   return static_cast<uint64_t>(CPUInfo1[2]) | (static_cast<uint64_t>(CPUInfo7[1]) << 32);
 }
 
+#elif defined(HAVE_NEON)
+
+uint64_t Matcher::get_HW()
+{
+#if defined(__linux__) && defined(__aarch64__)
+  // AArch64 HWCAP_ASIMD is bit 1 and HWCAP_SVE is bit 22
+  return static_cast<uint64_t>(getauxval(AT_HWCAP));
+#elif defined(__linux__) && defined(__arm__)
+  // ARMv7 HWCAP_NEON is bit 12
+  return (getauxval(AT_HWCAP) & (1UL << 12)) ? (1ULL << 1) : 0ULL;
+#else
+  // NEON is enabled at compile time and mandatory in AArch64
+  return 1ULL << 1;
+#endif
+}
+
 #else
 
 uint64_t Matcher::get_HW()
@@ -113,6 +186,110 @@ uint64_t Matcher::get_HW()
 
 uint64_t Matcher::HW = Matcher::get_HW();
 
+/// Count newlines in [s,e) 16 bytes at a time with SIMD, track the position after the last newline.
+size_t AbstractMatcher::count_lines(const char *s, const char *e, const char*& bol)
+{
+  size_t n = 0;
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2)
+  const __m128i vnl = _mm_set1_epi8('\n');
+  while (s + 16 <= e)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, vnl));
+    if (mask != 0)
+    {
+      n += popcount(mask);
+      bol = s + 32 - clz(mask);
+    }
+    s += 16;
+  }
+#elif defined(HAVE_NEON) && defined(__aarch64__)
+  const uint8x16_t vnl = vdupq_n_u8('\n');
+  while (s + 16 <= e)
+  {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(s));
+    uint8x8_t vmask4 = vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(v, vnl)), 4);
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vmask4), 0);
+    if (mask != 0)
+    {
+      n += popcountl(mask) >> 2;
+      bol = s + 16 - (clzl(mask) >> 2);
+    }
+    s += 16;
+  }
+#endif
+  while (s < e)
+  {
+    if (*s++ == '\n')
+    {
+      ++n;
+      bol = s;
+    }
+  }
+  return n;
+}
+
+/// Count columns in [s,e) 16 bytes at a time with SIMD by counting UTF-8 lead bytes, fall back to tab spacing at each tab.
+size_t AbstractMatcher::count_columns(const char *s, const char *e, size_t k, size_t t)
+{
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2)
+  const __m128i vtab = _mm_set1_epi8('\t');
+  const __m128i vhi2 = _mm_set1_epi8(static_cast<char>(0xC0));
+  const __m128i vcon = _mm_set1_epi8(static_cast<char>(0x80));
+  while (s + 16 <= e)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    uint32_t tabs = _mm_movemask_epi8(_mm_cmpeq_epi8(v, vtab));
+    uint32_t cont = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, vhi2), vcon));
+    if (tabs == 0)
+    {
+      k += 16 - popcount(cont);
+      s += 16;
+    }
+    else
+    {
+      uint32_t offset = ctz(tabs);
+      k += offset - popcount(cont & ((1U << offset) - 1));
+      k += 1 + (~k & (t - 1));
+      s += offset + 1;
+    }
+  }
+#elif defined(HAVE_NEON) && defined(__aarch64__)
+  const uint8x16_t vtab = vdupq_n_u8('\t');
+  const uint8x16_t vhi2 = vdupq_n_u8(0xC0);
+  const uint8x16_t vcon = vdupq_n_u8(0x80);
+  while (s + 16 <= e)
+  {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(s));
+    uint8x8_t vtabs4 = vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(v, vtab)), 4);
+    uint8x8_t vcont4 = vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(vandq_u8(v, vhi2), vcon)), 4);
+    uint64_t tabs = vget_lane_u64(vreinterpret_u64_u8(vtabs4), 0);
+    uint64_t cont = vget_lane_u64(vreinterpret_u64_u8(vcont4), 0);
+    if (tabs == 0)
+    {
+      k += 16 - (popcountl(cont) >> 2);
+      s += 16;
+    }
+    else
+    {
+      uint32_t offset = ctzl(tabs) >> 2;
+      k += offset - (popcountl(cont & ((1ULL << (offset << 2)) - 1)) >> 2);
+      k += 1 + (~k & (t - 1));
+      s += offset + 1;
+    }
+  }
+#endif
+  while (s < e)
+  {
+    if (*s == '\t')
+      k += 1 + (~k & (t - 1)); // count tab spacing
+    else
+      k += ((*s & 0xC0) != 0x80); // count column offset in UTF-8 chars
+    ++s;
+  }
+  return k;
+}
+
 /// Boyer-Moore preprocessing of the given pattern prefix pat of length len (<=255), generates bmd_ > 0 and bms_[] shifts.
 void Matcher::boyer_moore_init(const char *pat, size_t len)
 {
@@ -146,13 +323,16 @@ void Matcher::boyer_moore_init(const char *pat, size_t len)
     if (pat[j - 1] == pat[i])
       break;
   bmd_ = i - j + 1;
-#if !defined(HAVE_NEON)
   size_t score = 0;
   for (i = 0; i < n; ++i)
     score += bms_[static_cast<uint8_t>(pat[i])];
   score /= n;
   uint8_t fch = freq[static_cast<uint8_t>(pat[lcp_])];
+#if defined(HAVE_NEON)
+  if (!have_HW_NEON())
+#else
   if (!have_HW_SSE2() && !have_HW_AVX() && !have_HW_AVX512BW())
+#endif
   {
     // if scoring is high and freq is high, then use improved Boyer-Moore instead of memchr()
 #if defined(__SSE2__) || defined(__x86_64__) || _M_IX86_FP == 2
@@ -165,7 +345,29 @@ void Matcher::boyer_moore_init(const char *pat, size_t len)
       lcs_ = 0xffff;
 #endif
   }
-#endif
+}
+
+// read more input to continue searching at loc, keep the input that the reverse DFA may scan backward
+size_t Matcher::advance_more(size_t loc)
+{
+  size_t keep = loc;
+  if (pat_->rev_ != NULL)
+  {
+    // a match starts after the last byte that does not occur in the part before the factor
+    keep = lrv_;
+    for (size_t k = loc; k > keep; --k)
+    {
+      if (!pat_->rev_->part[static_cast<uint8_t>(buf_[k - 1])])
+      {
+        keep = k;
+        break;
+      }
+    }
+  }
+  set_current_match(keep - 1);
+  peek_more();
+  lrv_ = cur_ + 1;
+  return lrv_ + loc - keep;
 }
 
 // advance input cursor position after mismatch to align input for the next match
@@ -188,6 +390,336 @@ bool Matcher::advance()
         return false;
       }
     }
+    if (pat_->aho_ != NULL)
+    {
+      // search the leftmost string with the Aho-Corasick automaton of a pattern of many string alternatives
+      const Pattern::AhoCorasick *aho = pat_->aho_;
+      while (true)
+      {
+        const char *s = buf_ + loc;
+        const char *e = buf_ + end_;
+        const char *best = NULL;
+        uint32_t state = 0;
+        while (s < e)
+        {
+          uint8_t c = aho->map[static_cast<uint8_t>(*s++)];
+          if (state == 0)
+          {
+            // skip bytes that do not start a string
+            while (aho->dense[c] == 0 && s < e)
+              c = aho->map[static_cast<uint8_t>(*s++)];
+            state = aho->dense[c];
+          }
+          else
+          {
+            state = aho->next(state, c);
+          }
+          uint32_t n = aho->state[state].out;
+          if (n > 0 && (best == NULL || s - n < best))
+            best = s - n;
+          // done when no string that starts before the best can end later
+          if (best != NULL && s - aho->state[state].depth >= best)
+          {
+            set_current(best - buf_);
+            return true;
+          }
+        }
+        // rescan the partially matched string after reading more input
+        loc = s - aho->state[state].depth - buf_;
+        size_t pos = best != NULL ? best - buf_ - loc : 0;
+        size_t len = end_ - loc;
+        set_current_match(loc - 1);
+        peek_more();
+        loc = cur_ + 1;
+        if (end_ - loc <= len)
+        {
+          if (best == NULL)
+          {
+            set_current(loc);
+            return false;
+          }
+          set_current(loc + pos);
+          return true;
+        }
+      }
+    }
+    if (pat_->rev_ != NULL)
+    {
+      // search the required factor string, then scan backward with the reverse DFA to the leftmost start of a match
+      const Pattern::ReverseDFA *rev = pat_->rev_;
+      const uint8_t *next = &rev->next[0];
+      lrv_ = loc;
+      while (advance_string(rev->factor.c_str(), rev->factor.size(), 0, loc))
+      {
+        size_t k = cur_;
+        size_t start = rev->accept[1] ? k : end_;
+        uint8_t state = 1;
+        for (size_t s = k; s > lrv_; --s)
+        {
+          state = next[256 * state + static_cast<uint8_t>(buf_[s - 1])];
+          if (state == 0)
+            break;
+          if (rev->accept[state])
+            start = s - 1;
+        }
+        // skip starts that the 64-bit bitap array rejects, when the pattern is long enough
+        if (pat_->wbl_ > 0)
+          while (start <= k && start + pat_->wbl_ <= end_ && !Pattern::predict_match(pat_->wbp_, pat_->wbl_, &buf_[start]))
+            ++start;
+        if (start <= k)
+        {
+          set_current(start);
+          return true;
+        }
+        // a match that starts after this factor cannot scan backward past this factor
+        lrv_ = k + 1;
+        loc = k + 1;
+      }
+      return false;
+    }
+    if (pat_->nbp_ > 0)
+    {
+      // implements multi-literal search with nibble tables based on the Teddy algorithm of Hyperscan
+      const Pattern::Pred (*nib)[32] = pat_->nib_;
+      size_t k = pat_->nbp_;
+      while (true)
+      {
+        const char *s = buf_ + loc;
+        const char *e = buf_ + end_ - k + 1;
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX) || defined(HAVE_SSE2)
+#if defined(__AVX2__)
+        if (have_HW_AVX2())
+        {
+          __m256i vmask = _mm256_set1_epi8(0x0f);
+          __m256i vlo0 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[0])));
+          __m256i vhi0 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[0] + 16)));
+          __m256i vlo1 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[1])));
+          __m256i vhi1 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[1] + 16)));
+          __m256i vlo2 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[2])));
+          __m256i vhi2 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[2] + 16)));
+          while (s + 32 <= e)
+          {
+            __m256i vs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+            __m256i vm = _mm256_and_si256(_mm256_shuffle_epi8(vlo0, _mm256_and_si256(vs, vmask)), _mm256_shuffle_epi8(vhi0, _mm256_and_si256(_mm256_srli_epi16(vs, 4), vmask)));
+            if (k > 1)
+            {
+              vs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 1));
+              vm = _mm256_and_si256(vm, _mm256_and_si256(_mm256_shuffle_epi8(vlo1, _mm256_and_si256(vs, vmask)), _mm256_shuffle_epi8(vhi1, _mm256_and_si256(_mm256_srli_epi16(vs, 4), vmask))));
+              if (k > 2)
+              {
+                vs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 2));
+                vm = _mm256_and_si256(vm, _mm256_and_si256(_mm256_shuffle_epi8(vlo2, _mm256_and_si256(vs, vmask)), _mm256_shuffle_epi8(vhi2, _mm256_and_si256(_mm256_srli_epi16(vs, 4), vmask))));
+              }
+            }
+            uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(vm, _mm256_setzero_si256())));
+            while (mask != 0)
+            {
+              uint32_t offset = ctz(mask);
+              loc = s + offset - buf_;
+              if (min >= 4)
+              {
+                if (loc + min > end_ || Pattern::predict_match(pat_->pmh_, &buf_[loc], min))
+                {
+                  set_current(loc);
+                  return true;
+                }
+              }
+              else if (loc + 4 > end_ || Pattern::predict_match(pat_->pma_, &buf_[loc]) == 0)
+              {
+                set_current(loc);
+                return true;
+              }
+              mask &= mask - 1;
+            }
+            s += 32;
+          }
+        }
+#endif
+#if defined(__SSSE3__)
+        if (have_HW_SSSE3())
+        {
+          __m128i vmask = _mm_set1_epi8(0x0f);
+          __m128i vlo0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[0]));
+          __m128i vhi0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[0] + 16));
+          __m128i vlo1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[1]));
+          __m128i vhi1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[1] + 16));
+          __m128i vlo2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[2]));
+          __m128i vhi2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nib[2] + 16));
+          while (s + 16 <= e)
+          {
+            __m128i vs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+            __m128i vm = _mm_and_si128(_mm_shuffle_epi8(vlo0, _mm_and_si128(vs, vmask)), _mm_shuffle_epi8(vhi0, _mm_and_si128(_mm_srli_epi16(vs, 4), vmask)));
+            if (k > 1)
+            {
+              vs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 1));
+              vm = _mm_and_si128(vm, _mm_and_si128(_mm_shuffle_epi8(vlo1, _mm_and_si128(vs, vmask)), _mm_shuffle_epi8(vhi1, _mm_and_si128(_mm_srli_epi16(vs, 4), vmask))));
+              if (k > 2)
+              {
+                vs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 2));
+                vm = _mm_and_si128(vm, _mm_and_si128(_mm_shuffle_epi8(vlo2, _mm_and_si128(vs, vmask)), _mm_shuffle_epi8(vhi2, _mm_and_si128(_mm_srli_epi16(vs, 4), vmask))));
+              }
+            }
+            uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(vm, _mm_setzero_si128())) ^ 0xffff;
+            while (mask != 0)
+            {
+              uint32_t offset = ctz(mask);
+              loc = s + offset - buf_;
+              if (min >= 4)
+              {
+                if (loc + min > end_ || Pattern::predict_match(pat_->pmh_, &buf_[loc], min))
+                {
+                  set_current(loc);
+                  return true;
+                }
+              }
+              else if (loc + 4 > end_ || Pattern::predict_match(pat_->pma_, &buf_[loc]) == 0)
+              {
+                set_current(loc);
+                return true;
+              }
+              mask &= mask - 1;
+            }
+            s += 16;
+          }
+        }
+#endif
+#elif defined(HAVE_NEON) && defined(__aarch64__)
+        if (have_HW_NEON())
+        {
+          uint8x16_t vmask = vdupq_n_u8(0x0f);
+          uint8x16_t vlo0 = vld1q_u8(nib[0]);
+          uint8x16_t vhi0 = vld1q_u8(nib[0] + 16);
+          uint8x16_t vlo1 = vld1q_u8(nib[1]);
+          uint8x16_t vhi1 = vld1q_u8(nib[1] + 16);
+          uint8x16_t vlo2 = vld1q_u8(nib[2]);
+          uint8x16_t vhi2 = vld1q_u8(nib[2] + 16);
+          while (s + 16 <= e)
+          {
+            uint8x16_t vs = vld1q_u8(reinterpret_cast<const uint8_t*>(s));
+            uint8x16_t vm = vandq_u8(vqtbl1q_u8(vlo0, vandq_u8(vs, vmask)), vqtbl1q_u8(vhi0, vshrq_n_u8(vs, 4)));
+            if (k > 1)
+            {
+              vs = vld1q_u8(reinterpret_cast<const uint8_t*>(s + 1));
+              vm = vandq_u8(vm, vandq_u8(vqtbl1q_u8(vlo1, vandq_u8(vs, vmask)), vqtbl1q_u8(vhi1, vshrq_n_u8(vs, 4))));
+              if (k > 2)
+              {
+                vs = vld1q_u8(reinterpret_cast<const uint8_t*>(s + 2));
+                vm = vandq_u8(vm, vandq_u8(vqtbl1q_u8(vlo2, vandq_u8(vs, vmask)), vqtbl1q_u8(vhi2, vshrq_n_u8(vs, 4))));
+              }
+            }
+            // narrow the 16 byte mask of nonzero bytes to a 64 bit mask with a nibble per byte
+            uint8x8_t vmask4 = vshrn_n_u16(vreinterpretq_u16_u8(vtstq_u8(vm, vm)), 4);
+            uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vmask4), 0);
+            while (mask != 0)
+            {
+              uint32_t offset = ctzl(mask) >> 2;
+              loc = s + offset - buf_;
+              if (min >= 4)
+              {
+                if (loc + min > end_ || Pattern::predict_match(pat_->pmh_, &buf_[loc], min))
+                {
+                  set_current(loc);
+                  return true;
+                }
+              }
+              else if (loc + 4 > end_ || Pattern::predict_match(pat_->pma_, &buf_[loc]) == 0)
+              {
+                set_current(loc);
+                return true;
+              }
+              mask &= ~(0xfULL << (offset << 2));
+            }
+            s += 16;
+          }
+        }
+#endif
+        while (s < e)
+        {
+          uint8_t c = static_cast<uint8_t>(s[0]);
+          Pattern::Pred m = nib[0][c & 0x0f] & nib[0][16 + (c >> 4)];
+          for (size_t j = 1; j < k && m != 0; ++j)
+          {
+            c = static_cast<uint8_t>(s[j]);
+            m &= nib[j][c & 0x0f] & nib[j][16 + (c >> 4)];
+          }
+          if (m != 0)
+          {
+            loc = s - buf_;
+            if (min >= 4)
+            {
+              if (loc + min > end_ || Pattern::predict_match(pat_->pmh_, &buf_[loc], min))
+              {
+                set_current(loc);
+                return true;
+              }
+            }
+            else if (loc + 4 > end_ || Pattern::predict_match(pat_->pma_, &buf_[loc]) == 0)
+            {
+              set_current(loc);
+              return true;
+            }
+          }
+          ++s;
+        }
+        loc = s - buf_;
+        set_current_match(loc - 1);
+        peek_more();
+        loc = cur_ + 1;
+        if (loc + k > end_)
+        {
+          set_current(loc);
+          return false;
+        }
+      }
+    }
+    if (pat_->wbl_ > 0)
+    {
+      // implements 64-bit bitap over the first n > 8 bytes of patterns, the state is reset after reading more input
+      const uint64_t *bit = pat_->wbp_;
+      size_t n = pat_->wbl_;
+      uint64_t state = ~0ULL;
+      uint64_t mask = 1ULL << (n - 1);
+      size_t low = loc;
+      while (true)
+      {
+        const char *s = buf_ + loc;
+        const char *e = buf_ + end_;
+        while (s < e)
+        {
+          state = (state << 1) | bit[static_cast<uint8_t>(*s)];
+          if ((state & mask) == 0)
+            break;
+          ++s;
+        }
+        if (s < e)
+        {
+          s -= n - 1;
+          loc = s - buf_;
+          if (Pattern::predict_match(pat_->pmh_, s, min))
+          {
+            set_current(loc);
+            return true;
+          }
+          low = loc + 1;
+          loc += n;
+        }
+        else
+        {
+          // rescan the last n - 1 bytes after reading more input, but not before the lowest possible start of a match
+          size_t keep = end_ - low < n - 1 ? low : end_ - n + 1;
+          size_t more = end_ - keep;
+          set_current_match(keep - 1);
+          peek_more();
+          loc = low = cur_ + 1;
+          state = ~0ULL;
+          if (end_ - loc <= more)
+          {
+            set_current(loc);
+            return false;
+          }
+        }
+      }
+    }
     if (min >= 4)
     {
       const Pattern::Pred *bit = pat_->bit_;
@@ -346,8 +878,12 @@ bool Matcher::advance()
       }
     }
   }
-  const char *pre = pat_->pre_;
-  size_t len = pat_->len_; // actually never more than 255
+  return advance_string(pat_->pre_, pat_->len_, min, loc);
+}
+
+// advance input cursor position to the next string pre of length len, followed by a predicted match of at least min bytes
+bool Matcher::advance_string(const char *pre, size_t len, size_t min, size_t loc)
+{
   if (len == 1)
   {
     while (true)
@@ -362,9 +898,7 @@ bool Matcher::advance()
         return true;
       }
       loc = e - buf_;
-      set_current_match(loc - 1);
-      peek_more();
-      loc = cur_ + 1;
+      loc = advance_more(loc);
       if (loc + len > end_)
       {
         set_current(loc);
@@ -604,25 +1138,25 @@ bool Matcher::advance()
         }
       }
 #elif defined(HAVE_NEON)
-      // implements SIMD string search scheme based on in http://0x80.pl/articles/simd-friendly-karp-rabin.html
-      uint8x16_t vlcp = vdupq_n_u8(pre[lcp_]);
-      uint8x16_t vlcs = vdupq_n_u8(pre[lcs_]);
-      while (s + 16 < e)
+#if defined(__ARM_FEATURE_SVE)
+      if (have_HW_SVE())
       {
-        uint8x16_t vlcpm = vld1q_u8(reinterpret_cast<const uint8_t*>(s));
-        uint8x16_t vlcsm = vld1q_u8(reinterpret_cast<const uint8_t*>(s) + lcs_ - lcp_);
-        uint8x16_t vlcpeq = vceqq_u8(vlcp, vlcpm);
-        uint8x16_t vlcseq = vceqq_u8(vlcs, vlcsm);
-        uint8x16_t vmask8 = vandq_u8(vlcpeq, vlcseq);
-        uint64x2_t vmask64 = vreinterpretq_u64_u8(vmask8);
-        uint64_t mask = vgetq_lane_u64(vmask64, 0);
-        if (mask != 0)
-        {
-          for (int i = 0; i < 8; ++i)
+        // implements SIMD string search scheme based on in http://0x80.pl/articles/simd-friendly-karp-rabin.html
+        svbool_t all = svptrue_b8();
+        svuint8_t vlcp = svdup_n_u8(pre[lcp_]);
+        svuint8_t vlcs = svdup_n_u8(pre[lcs_]);
+        size_t n = svcntb();
+        while (s + n < e)
+        {
+          svuint8_t vlcpm = svld1_u8(all, reinterpret_cast<const uint8_t*>(s));
+          svuint8_t vlcsm = svld1_u8(all, reinterpret_cast<const uint8_t*>(s + lcs_ - lcp_));
+          svbool_t mask = svcmpeq_u8(svcmpeq_u8(all, vlcpm, vlcp), vlcsm, vlcs);
+          while (svptest_any(all, mask))
           {
-            if ((mask & 0xff) && std::memcmp(s - lcp_ + i, pre, len) == 0)
+            uint32_t offset = static_cast<uint32_t>(svcntp_b8(all, svbrkb_b_z(all, mask)));
+            if (std::memcmp(s - lcp_ + offset, pre, len) == 0)
             {
-              loc = s - lcp_ + i - buf_;
+              loc = s - lcp_ + offset - buf_;
               set_current(loc);
               if (min == 0)
                 return true;
@@ -637,17 +1171,33 @@ bool Matcher::advance()
                   return true;
               }
             }
-            mask >>= 8;
+            mask = svbic_b_z(all, mask, svbrka_b_z(all, mask));
           }
+          s += n;
         }
-        mask = vgetq_lane_u64(vmask64, 1);
-        if (mask != 0)
+      }
+      else
+#endif
+      if (have_HW_NEON())
+      {
+        // implements SIMD string search scheme based on in http://0x80.pl/articles/simd-friendly-karp-rabin.html
+        uint8x16_t vlcp = vdupq_n_u8(pre[lcp_]);
+        uint8x16_t vlcs = vdupq_n_u8(pre[lcs_]);
+        while (s + 16 < e)
         {
-          for (int i = 0; i < 8; ++i)
+          uint8x16_t vlcpm = vld1q_u8(reinterpret_cast<const uint8_t*>(s));
+          uint8x16_t vlcsm = vld1q_u8(reinterpret_cast<const uint8_t*>(s + lcs_ - lcp_));
+          uint8x16_t vlcpeq = vceqq_u8(vlcp, vlcpm);
+          uint8x16_t vlcseq = vceqq_u8(vlcs, vlcsm);
+          // narrow the 16 byte mask to a 64 bit mask with a nibble per byte, since NEON has no movemask
+          uint8x8_t vmask4 = vshrn_n_u16(vreinterpretq_u16_u8(vandq_u8(vlcpeq, vlcseq)), 4);
+          uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vmask4), 0);
+          while (mask != 0)
           {
-            if ((mask & 0xff) && std::memcmp(s - lcp_ + i + 8, pre, len) == 0)
+            uint32_t offset = ctzl(mask) >> 2;
+            if (std::memcmp(s - lcp_ + offset, pre, len) == 0)
             {
-              loc = s - lcp_ + i + 8 - buf_;
+              loc = s - lcp_ + offset - buf_;
               set_current(loc);
               if (min == 0)
                 return true;
@@ -662,10 +1212,10 @@ bool Matcher::advance()
                   return true;
               }
             }
-            mask >>= 8;
+            mask &= ~(0xfULL << (offset << 2));
           }
+          s += 16;
         }
-        s += 16;
       }
 #endif
       while (s < e)
@@ -698,9 +1248,7 @@ bool Matcher::advance()
         ++s;
       }
       loc = s - lcp_ - buf_;
-      set_current_match(loc - 1);
-      peek_more();
-      loc = cur_ + 1;
+      loc = advance_more(loc);
       if (loc + len > end_)
       {
         set_current(loc);
@@ -760,9 +1308,7 @@ bool Matcher::advance()
       }
       s -= len - 1;
       loc = s - buf_;
-      set_current_match(loc - 1);
-      peek_more();
-      loc = cur_ + 1;
+      loc = advance_more(loc);
       if (loc + len > end_)
       {
         set_current(loc);
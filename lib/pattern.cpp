@@ -34,11 +34,25 @@
 @copyright (c) BSD-3 License - see LICENSE.txt
 */
 
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+
 #include <reflex/pattern.h>
 #include <reflex/timer.h>
 #include <cstdlib>
 #include <cerrno>
 #include <cmath>
+#include <algorithm>
+#include <iterator>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if !((defined(__WIN32__) || defined(_WIN32) || defined(WIN32) || defined(_WIN64) || defined(__BORLANDC__)) && !defined(__CYGWIN__) && !defined(__MINGW32__) && !defined(__MINGW64__))
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
 
 /// DFA compaction: -1 == reverse order edge compression (best); 1 == edge compression; 0 == no edge compression.
 /** Edge compression reorders edges to produce fewer tests when executed in the compacted order.
@@ -50,6 +64,17 @@
 */
 #define WITH_COMPACT_DFA -1
 
+/// Parallel DFA construction with pattern option j: 1 == compute transitions with C++11 std::thread workers, requires C++11 and linking with -pthread, defined by configure when available; 0 == option j is ignored.
+#ifndef WITH_PARALLEL_DFA
+# define WITH_PARALLEL_DFA 0
+#endif
+
+#if WITH_PARALLEL_DFA
+# include <atomic>
+# include <exception>
+# include <thread>
+#endif
+
 #ifdef DEBUG
 # define DBGLOGPOS(p) \
   if ((p).accept()) \
@@ -79,6 +104,27 @@
 
 namespace reflex {
 
+/// Check if sorted vector `s1` is a subset of sorted vector `s2`.
+template<typename T>
+static inline bool is_subset(
+    const std::vector<T>& s1,
+    const std::vector<T>& s2)
+{
+  return s1.size() <= s2.size() && std::includes(s2.begin(), s2.end(), s1.begin(), s1.end());
+}
+
+/// Insert sorted vector `s2` into sorted vector `s1`, keeping `s1` sorted without duplicates.
+template<typename T>
+static inline void set_insert(
+    std::vector<T>&       s1,
+    const std::vector<T>& s2)
+{
+  std::vector<T> s;
+  s.reserve(s1.size() + s2.size());
+  std::set_union(s1.begin(), s1.end(), s2.begin(), s2.end(), std::back_inserter(s));
+  s1.swap(s);
+}
+
 #if (defined(__WIN32__) || defined(_WIN32) || defined(WIN32) || defined(_WIN64) || defined(__BORLANDC__)) && !defined(__CYGWIN__) && !defined(__MINGW32__) && !defined(__MINGW64__)
 inline int fopen_s(FILE **file, const char *name, const char *mode) { return ::fopen_s(file, name, mode); }
 #else
@@ -163,9 +209,12 @@ void Pattern::init(const char *opt, const uint8_t *pred)
 {
   init_options(opt);
   nop_ = 0;
+  ncl_ = 0;
   len_ = 0;
   min_ = 0;
   one_ = false;
+  nbp_ = 0;
+  wbl_ = 0;
   if (opc_ || fsm_)
   {
     if (pred != NULL)
@@ -173,6 +222,7 @@ void Pattern::init(const char *opt, const uint8_t *pred)
       len_ = pred[0];
       min_ = pred[1] & 0x0f;
       one_ = pred[1] & 0x10;
+      nbp_ = (pred[1] >> 5) & 0x03;
       memcpy(pre_, pred + 2, len_);
       if (min_ > 0)
       {
@@ -193,6 +243,9 @@ void Pattern::init(const char *opt, const uint8_t *pred)
           for (size_t i = 0; i < Const::HASH; ++i)
             pma_[i] = ~pred[i + n];
         }
+        n += Const::HASH;
+        for (size_t i = 0; i < nbp_; ++i)
+          memcpy(nib_[i], pred + n + 32 * i, 32);
       }
     }
   }
@@ -204,10 +257,23 @@ void Pattern::init(const char *opt, const uint8_t *pred)
     Map       lookahead;
     // parse the regex pattern to construct the followpos NFA without epsilon transitions
     parse(startpos, followpos, modifiers, lookahead);
+    // keep the NFA to construct DFA states on demand, when requested and applicable
+    if (opt_.l && lazy_nfa(startpos, followpos, modifiers, lookahead))
+      return;
+    // a pattern of string alternatives only is searched and matched with an Aho-Corasick automaton of the tree DFA, without constructing a DFA unless code or tables are requested
+    if (startpos.empty() && tfa_.tree != NULL && aho_corasick() && opt_.f.empty() && !opt_.d && !opt_.h)
+    {
+      tfa_.clear();
+      return;
+    }
     // start state = startpos = firstpost of the followpos NFA, also merge the tree DFA root when non-NULL
-    DFA::State *start = dfa_.state(tfa_.tree, startpos);
+    Flatpos pos(startpos.begin(), startpos.end());
+    DFA::State *start = dfa_.state(tfa_.tree, pos);
     // compile the NFA into a DFA
     compile(start, followpos, modifiers, lookahead);
+    // minimize the DFA, when requested
+    if (opt_.h)
+      minimize_dfa(start);
     // assemble DFA opcode tables or direct code
     assemble(start);
     // delete the DFA
@@ -218,7 +284,12 @@ void Pattern::init(const char *opt, const uint8_t *pred)
 void Pattern::init_options(const char *opt)
 {
   opt_.b = false;
+  opt_.d = false;
+  opt_.g = 0;
+  opt_.h = false;
   opt_.i = false;
+  opt_.j = 1;
+  opt_.l = false;
   opt_.m = false;
   opt_.o = false;
   opt_.p = false;
@@ -237,16 +308,39 @@ void Pattern::init_options(const char *opt)
         case 'b':
           opt_.b = true;
           break;
+        case 'd':
+          opt_.d = true;
+          break;
         case 'e':
           opt_.e = (*(s += (s[1] == '=') + 1) == ';' || *s == '\0' ? 256 : *s++);
           --s;
           break;
+        case 'g':
+          opt_.g = 0;
+          s += (s[1] == '=');
+          while (std::isdigit(static_cast<unsigned char>(s[1])))
+            opt_.g = 10 * opt_.g + (*++s - '0');
+          if (opt_.g == 0)
+            opt_.g = Const::JMIN;
+          break;
         case 'p':
           opt_.p = true;
           break;
+        case 'h':
+          opt_.h = true;
+          break;
         case 'i':
           opt_.i = true;
           break;
+        case 'j':
+          opt_.j = 0;
+          s += (s[1] == '=');
+          while (std::isdigit(static_cast<unsigned char>(s[1])))
+            opt_.j = 10 * opt_.j + (*++s - '0');
+          break;
+        case 'l':
+          opt_.l = true;
+          break;
         case 'm':
           opt_.m = true;
           break;
@@ -362,7 +456,7 @@ void Pattern::parse(
   do
   {
     Location end = loc;
-    if (!opt_.q && !opt_.x)
+    if (!opt_.q && !opt_.x && !opt_.l)
     {
       // TODO: perhaps allow \< \> and ^ $ anchors with string patterns?
       while (true)
@@ -1272,6 +1366,234 @@ Pattern::Char Pattern::parse_esc(Location& loc, Chars *chars) const
   return c;
 }
 
+bool Pattern::aho_corasick()
+{
+  DBGLOG("BEGIN aho_corasick()");
+  timer_type t;
+  timer_start(t);
+  // the prefix search of strings with a common prefix is faster than the Aho-Corasick automaton, as is the empty string
+  const Tree::Node *tree = tfa_.tree;
+  if (tree->accept > 0)
+    return false;
+  size_t branches = 0;
+  for (Char c = 0; c < 256 && branches < 2; ++c)
+    if (tree->edge[c] != NULL)
+      ++branches;
+  if (branches < 2)
+    return false;
+  AhoCorasick *aho = new AhoCorasick;
+  // number the tree DFA nodes breadth first, the edges of each node are stored in order
+  std::vector<const Tree::Node*> nodes(1, tree);
+  size_t strings = 0;
+  size_t shortest = 0;
+  AhoCorasick::State root = { 0, 0, 0, 0 };
+  aho->state.push_back(root);
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    const Tree::Node *node = nodes[i];
+    aho->accept.push_back(node->accept);
+    if (node->accept > 0 && strings++ == 0)
+      shortest = aho->state[i].depth;
+    aho->state[i].first = static_cast<uint32_t>(aho->edge.size());
+    for (Char c = 0; c < 256; ++c)
+    {
+      if (node->edge[c] != NULL)
+      {
+        // the tree DFA of a case-insensitive pattern merges upper case edges into lower case edges
+        if (opt_.i && c >= 'A' && c <= 'Z')
+        {
+          delete aho;
+          return false;
+        }
+        AhoCorasick::Edge edge = { static_cast<uint32_t>(nodes.size()), static_cast<uint8_t>(c) };
+        AhoCorasick::State state = { 0, 0, 0, aho->state[i].depth + 1 };
+        aho->edge.push_back(edge);
+        aho->state.push_back(state);
+        nodes.push_back(node->edge[c]);
+      }
+    }
+  }
+  root.first = static_cast<uint32_t>(aho->edge.size());
+  aho->state.push_back(root);
+  aho->accept.push_back(0);
+  // worth it for more strings than the nibble tables can search
+  if (strings <= 16 * Const::NMAX)
+  {
+    delete aho;
+    return false;
+  }
+  // each byte that labels an edge gets its own class, the other bytes share one class
+  bool used[256] = { false };
+  for (size_t j = 0; j < aho->edge.size(); ++j)
+    used[aho->edge[j].label] = true;
+  aho->cls = 0;
+  for (Char c = 0; c < 256; ++c)
+    if (used[c])
+      aho->map[c] = static_cast<uint8_t>(aho->cls++);
+  if (aho->cls < 256)
+  {
+    for (Char c = 0; c < 256; ++c)
+      if (!used[c])
+        aho->map[c] = static_cast<uint8_t>(aho->cls);
+    ++aho->cls;
+  }
+  if (opt_.i)
+    for (Char c = 'A'; c <= 'Z'; ++c)
+      aho->map[c] = aho->map[lowercase(c)];
+  for (size_t j = 0; j < aho->edge.size(); ++j)
+    aho->edge[j].label = aho->map[aho->edge[j].label];
+  // the shallow states visited most get dense transitions within the size limit of a dense transition table
+  aho->rows = static_cast<uint32_t>(std::min(nodes.size(), static_cast<size_t>(Const::TMAX / aho->cls)));
+  aho->dense.resize(static_cast<size_t>(aho->rows) * aho->cls, 0);
+  // the failure link of a state is computed from the failure link of its parent breadth first, a dense row starts as a copy of the row of the failure state
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    uint32_t fail = aho->state[i].fail;
+    if (i > 0 && i < aho->rows)
+      std::copy(&aho->dense[fail * aho->cls], &aho->dense[fail * aho->cls] + aho->cls, &aho->dense[i * aho->cls]);
+    for (uint32_t j = aho->state[i].first; j < aho->state[i + 1].first; ++j)
+    {
+      const AhoCorasick::Edge& edge = aho->edge[j];
+      AhoCorasick::State& state = aho->state[edge.target];
+      if (i > 0)
+        state.fail = aho->next(fail, edge.label);
+      state.out = nodes[edge.target]->accept > 0 ? state.depth : aho->state[state.fail].out;
+      if (i < aho->rows)
+        aho->dense[i * aho->cls + edge.label] = edge.target;
+    }
+  }
+  // the automaton replaces the DFA: the trie of the automaton matches the strings, the shortest string is at least one byte
+  aho_ = aho;
+  acc_.assign(end_.size(), false);
+  for (size_t i = 0; i < nodes.size(); ++i)
+    if (nodes[i]->accept > 0 && nodes[i]->accept <= end_.size())
+      acc_[nodes[i]->accept - 1] = true;
+  len_ = 0;
+  min_ = std::min(shortest, static_cast<size_t>(8));
+  vno_ = nodes.size();
+  eno_ = aho->edge.size();
+  vms_ = timer_elapsed(t);
+  ems_ = 0.0;
+  wms_ = 0.0;
+  DBGLOG("END aho_corasick()");
+  return true;
+}
+
+bool Pattern::lazy_nfa(
+    const Positions& startpos,
+    const Follow&    followpos,
+    const Map&       modifiers,
+    const Map&       lookahead)
+{
+  DBGLOG("BEGIN lazy_nfa()");
+  // the lazy DFA has no lookahead heads and tails and no meta transitions for anchors and word boundaries
+  for (Map::const_iterator i = lookahead.begin(); i != lookahead.end(); ++i)
+    if (!i->second.empty())
+      return false;
+  for (Positions::const_iterator p = startpos.begin(); p != startpos.end(); ++p)
+    if (!p->accept() && is_meta_at(p->loc(), modifiers))
+      return false;
+  for (Follow::const_iterator i = followpos.begin(); i != followpos.end(); ++i)
+    for (Positions::const_iterator p = i->second.begin(); p != i->second.end(); ++p)
+      if (!p->accept() && is_meta_at(p->loc(), modifiers))
+        return false;
+  lnf_ = new LazyNFA;
+  lnf_->start.assign(startpos.begin(), startpos.end());
+  trim_lazy(&lnf_->start);
+  for (Follow::const_iterator i = followpos.begin(); i != followpos.end(); ++i)
+    lnf_->followpos.insert(lnf_->followpos.end(), Flatfollow::value_type(i->first, Flatpos(i->second.begin(), i->second.end())));
+  lnf_->modifiers = modifiers;
+  // no DFA is constructed, assume all subpatterns are reachable
+  acc_.assign(end_.size(), true);
+  vno_ = 0;
+  eno_ = 0;
+  vms_ = 0.0;
+  ems_ = 0.0;
+  wms_ = 0.0;
+  DBGLOG("END lazy_nfa()");
+  return true;
+}
+
+bool Pattern::is_meta_at(
+    Location   loc,
+    const Map& modifiers) const
+{
+  if (is_modified('q', modifiers, loc))
+    return false;
+  Char c = at(loc);
+  return c == '^' || c == '$' || escapes_at(loc, "ijkAzBb<>") != '\0';
+}
+
+void Pattern::LazyDFA::clear()
+{
+  for (std::vector<State*>::iterator i = all_.begin(); i != all_.end(); ++i)
+    delete *i;
+  all_.clear();
+  table_.clear();
+  lazypos_.clear();
+  start_ = NULL;
+}
+
+void Pattern::LazyDFA::init()
+{
+  Flatpos pos(nfa_->start);
+  start_ = state(pos);
+}
+
+Pattern::LazyDFA::State *Pattern::LazyDFA::construct(State *from)
+{
+  Moves moves;
+  pat_->compile_transition(
+      from,
+      nfa_->followpos,
+      lazypos_,
+      nfa_->modifiers,
+      nfa_->lookahead,
+      moves);
+  if (all_.size() + moves.size() > CACHE)
+  {
+    // the cache is full: flush all states, then restore the start state and this state with its accept and redo
+    bool is_start = from == start_;
+    Flatpos pos(*from);
+    Accept accept = from->accept;
+    bool redo = from->redo;
+    clear();
+    ++flushes_;
+    init();
+    from = is_start ? start_ : state(pos);
+    from->accept = accept;
+    from->redo = redo;
+  }
+  for (int c = 0; c < 256; ++c)
+    from->jump[c] = NULL;
+  for (Moves::iterator i = moves.begin(); i != moves.end(); ++i)
+  {
+    State *target = state(i->second);
+    Char lo = i->first.lo();
+    Char hi = i->first.hi();
+    for (Char c = lo; c <= hi; ++c)
+      if (i->first.contains(c))
+        from->jump[c] = target;
+  }
+  from->halt = moves.empty();
+  from->expanded = true;
+  return from;
+}
+
+Pattern::LazyDFA::State *Pattern::LazyDFA::state(Flatpos& pos)
+{
+  uint64_t h = hash_pos(&pos);
+  DFA::State **at = table_.find(pos, h);
+  if (*at != NULL)
+    return static_cast<State*>(*at);
+  State *target = new State;
+  target->assign(NULL, pos);
+  target->hash = h;
+  table_.insert(at, target);
+  all_.push_back(target);
+  return target;
+}
+
 void Pattern::compile(
     DFA::State *start,
     Follow&     followpos,
@@ -1288,28 +1610,63 @@ void Pattern::compile(
   // construct the DFA
   acc_.resize(end_.size(), false);
   trim_lazy(start);
-  // hash table with 64K entries (uint16_t indexed)
-  DFA::State **table = new DFA::State*[65536];
-  for (int i = 0; i < 65536; ++i)
-    table[i] = NULL;
+  // followpos with sorted vectors for fast subset and union operations
+  Flatfollow follow;
+  for (Follow::const_iterator i = followpos.begin(); i != followpos.end(); ++i)
+    follow.insert(follow.end(), Flatfollow::value_type(i->first, Flatpos(i->second.begin(), i->second.end())));
+  // memoized lazy followpos
+  Flatfollow lazypos;
+  // states by positions
+  Table table;
   // start state should only be discoverable (to possibly cycle back to) if no tree DFA was constructed
   if (start->tnode == NULL)
-    table[hash_pos(start)] = start;
+  {
+    start->hash = hash_pos(start);
+    table.insert(table.find(*start, start->hash), start);
+  }
+  // parallel construction with option j: the transitions of the frontier states are computed in advance by worker threads
+  size_t threads = 1;
+#if WITH_PARALLEL_DFA
+  threads = opt_.j > 0 ? opt_.j : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+#endif
+  std::vector<Moves> frontier;
+  std::vector<Flatfollow> lazyposes(threads);
+  size_t ahead = 0;
   // last added state
   DFA::State *last_state = start;
   for (DFA::State *state = start; state; state = state->next)
   {
     Moves moves;
     timer_start(et);
-    // use the tree DFA accept state, if present
-    if (state->tnode != NULL && state->tnode->accept > 0)
-      state->accept = state->tnode->accept;
-    compile_transition(
-        state,
-        followpos,
-        modifiers,
-        lookahead,
-        moves);
+    if (threads > 1)
+    {
+      // all transitions of the frontier are used: compute the transitions of the states added since
+      if (ahead == frontier.size())
+      {
+        compile_frontier(
+            state,
+            follow,
+            lazyposes,
+            modifiers,
+            lookahead,
+            frontier);
+        ahead = 0;
+      }
+      moves.swap(frontier[ahead++]);
+    }
+    else
+    {
+      // use the tree DFA accept state, if present
+      if (state->tnode != NULL && state->tnode->accept > 0)
+        state->accept = state->tnode->accept;
+      compile_transition(
+          state,
+          follow,
+          lazypos,
+          modifiers,
+          lookahead,
+          moves);
+    }
     if (state->tnode != NULL)
     {
       // merge tree DFA transitions into the final DFA transitions to target states
@@ -1361,7 +1718,7 @@ void Pattern::compile(
             {
               if (common.contains(c))
               {
-                Positions pos(i->second);
+                Flatpos pos(i->second);
                 if (opt_.i && std::isalpha(c))
                 {
                   if (c >= 'a' && c <= 'z')
@@ -1426,29 +1783,17 @@ void Pattern::compile(
     Moves::iterator end = moves.end();
     for (Moves::iterator i = moves.begin(); i != end; ++i)
     {
-      Positions& pos = i->second;
+      Flatpos& pos = i->second;
       if (!pos.empty())
       {
-        uint16_t h = hash_pos(&pos);
-        DFA::State **branch_ptr = &table[h];
-        DFA::State *target_state = *branch_ptr;
-        // binary search the target state for a possible matching state in the hash table overflow tree
-        while (target_state != NULL)
-        {
-          if (pos < *target_state)
-            target_state = *(branch_ptr = &target_state->left);
-          else if (pos > *target_state)
-            target_state = *(branch_ptr = &target_state->right);
-          else
-            break;
-        }
+        uint64_t h = hash_pos(&pos);
+        DFA::State **at = table.find(pos, h);
+        DFA::State *target_state = *at;
         if (target_state == NULL)
         {
           target_state = last_state = last_state->next = dfa_.state(NULL, pos);
-          if (branch_ptr != NULL)
-            *branch_ptr = target_state;
-          else
-            table[h] = target_state;
+          target_state->hash = h;
+          table.insert(at, target_state);
         }
         Char lo = i->first.lo();
         Char max = i->first.hi();
@@ -1476,12 +1821,283 @@ void Pattern::compile(
       acc_[state->accept - 1] = true;
     ++vno_;
   }
-  delete[] table;
   tfa_.clear();
   vms_ = timer_elapsed(vt) - ems_;
   DBGLOG("END compile()");
 }
 
+void Pattern::compile_frontier(
+    DFA::State              *state,
+    const Flatfollow&        followpos,
+    std::vector<Flatfollow>& lazypos,
+    const Map&               modifiers,
+    const Map&               lookahead,
+    std::vector<Moves>&      moves) const
+{
+  DBGLOG("BEGIN compile_frontier()");
+  std::vector<DFA::State*> states;
+  for (; state != NULL; state = state->next)
+    states.push_back(state);
+  moves.clear();
+  moves.resize(states.size());
+  // at least 64 frontier states per worker, since small frontiers are not worth the threads
+  size_t workers = std::min(lazypos.size(), (states.size() + 63) / 64);
+#if WITH_PARALLEL_DFA
+  if (workers <= 1)
+    workers = 0;
+  // each worker takes the next state of the frontier and uses its own lazy followpos memo
+  std::atomic<size_t> next(0);
+  std::vector<std::exception_ptr> errors(workers);
+  std::vector<std::thread> pool;
+  for (size_t w = 0; w < workers; ++w)
+  {
+    pool.push_back(std::thread([&, w]() {
+      try
+      {
+        size_t i;
+        while ((i = next.fetch_add(1)) < states.size())
+        {
+          // use the tree DFA accept state, if present
+          if (states[i]->tnode != NULL && states[i]->tnode->accept > 0)
+            states[i]->accept = states[i]->tnode->accept;
+          compile_transition(states[i], followpos, lazypos[w], modifiers, lookahead, moves[i]);
+        }
+      }
+      catch (...)
+      {
+        errors[w] = std::current_exception();
+      }
+    }));
+  }
+  for (size_t w = 0; w < workers; ++w)
+    pool[w].join();
+  for (size_t w = 0; w < workers; ++w)
+    if (errors[w])
+      std::rethrow_exception(errors[w]);
+#else
+  workers = 0;
+#endif
+  if (workers == 0)
+  {
+    for (size_t i = 0; i < states.size(); ++i)
+    {
+      if (states[i]->tnode != NULL && states[i]->tnode->accept > 0)
+        states[i]->accept = states[i]->tnode->accept;
+      compile_transition(states[i], followpos, lazypos[0], modifiers, lookahead, moves[i]);
+    }
+  }
+  DBGLOG("END compile_frontier()");
+}
+
+void Pattern::minimize_dfa(DFA::State *start)
+{
+  DBGLOG("BEGIN minimize_dfa()");
+  timer_type t;
+  timer_start(t);
+  // symbols are the byte classes and the meta chars used, the dead state n is an implicit sink
+  classify_dfa(start);
+  int meta[META_MAX - META_MIN];
+  for (int i = 0; i < META_MAX - META_MIN; ++i)
+    meta[i] = -1;
+  int nsym = static_cast<int>(ncl_);
+  int n = 0;
+  for (DFA::State *state = start; state; state = state->next)
+  {
+    state->index = n++;
+    for (DFA::State::Edges::const_iterator i = state->edges.begin(); i != state->edges.end(); ++i)
+    {
+#if WITH_COMPACT_DFA == -1
+      Char lo = i->first;
+      Char hi = i->second.first;
+#else
+      Char lo = i->second.first;
+      Char hi = i->first;
+#endif
+      if (is_meta(lo))
+        for (Char c = lo; c <= hi; ++c)
+          if (meta[c - META_MIN] < 0)
+            meta[c - META_MIN] = nsym++;
+    }
+  }
+  int N = n + 1;
+  std::vector<int> delta(static_cast<size_t>(N) * nsym, n);
+  std::vector<DFA::State*> states(n);
+  for (DFA::State *state = start; state; state = state->next)
+  {
+    int *row = &delta[static_cast<size_t>(state->index) * nsym];
+    states[state->index] = state;
+    for (DFA::State::Edges::const_iterator i = state->edges.begin(); i != state->edges.end(); ++i)
+    {
+#if WITH_COMPACT_DFA == -1
+      Char lo = i->first;
+      Char hi = i->second.first;
+#else
+      Char lo = i->second.first;
+      Char hi = i->first;
+#endif
+      int target = i->second.second != NULL ? static_cast<int>(i->second.second->index) : n;
+      if (is_meta(lo))
+        for (Char c = lo; c <= hi; ++c)
+          row[meta[c - META_MIN]] = target;
+      else
+        for (Char c = lo; c <= hi; ++c)
+          row[bcl_[c]] = target;
+    }
+  }
+  // inverse transitions per symbol and target state, stored compactly
+  std::vector<int> inv_beg(static_cast<size_t>(nsym) * N + 1, 0);
+  std::vector<int> inv(static_cast<size_t>(nsym) * N);
+  for (int s = 0; s < N; ++s)
+    for (int a = 0; a < nsym; ++a)
+      ++inv_beg[static_cast<size_t>(a) * N + (s < n ? delta[static_cast<size_t>(s) * nsym + a] : n) + 1];
+  for (size_t k = 1; k < inv_beg.size(); ++k)
+    inv_beg[k] += inv_beg[k - 1];
+  {
+    std::vector<int> fill(inv_beg.begin(), inv_beg.end() - 1);
+    for (int s = 0; s < N; ++s)
+      for (int a = 0; a < nsym; ++a)
+        inv[fill[static_cast<size_t>(a) * N + (s < n ? delta[static_cast<size_t>(s) * nsym + a] : n)]++] = s;
+  }
+  // initial partition: the start state and the dead state are kept apart, final states are distinguished by accept, redo and lookaheads
+  std::vector<int> elem(N), loc(N), blk(N), beg, end, mark;
+  {
+    typedef std::pair<std::pair<Accept,bool>,std::pair<Lookaheads,Lookaheads> > Key;
+    std::map<Key,int> keys;
+    for (int s = 0; s < N; ++s)
+    {
+      if (s == 0 || s == n)
+      {
+        blk[s] = static_cast<int>(beg.size());
+        beg.push_back(0);
+      }
+      else
+      {
+        const DFA::State *state = states[s];
+        Key key(std::pair<Accept,bool>(state->accept, state->redo), std::pair<Lookaheads,Lookaheads>(state->heads, state->tails));
+        std::map<Key,int>::iterator i = keys.find(key);
+        if (i == keys.end())
+        {
+          i = keys.insert(std::pair<Key,int>(key, static_cast<int>(beg.size()))).first;
+          beg.push_back(0);
+        }
+        blk[s] = i->second;
+      }
+      ++beg[blk[s]];
+    }
+    int nblk = static_cast<int>(beg.size());
+    end.resize(nblk);
+    mark.resize(nblk, 0);
+    int k = 0;
+    for (int b = 0; b < nblk; ++b)
+    {
+      int size = beg[b];
+      beg[b] = end[b] = k;
+      k += size;
+    }
+    for (int s = 0; s < N; ++s)
+    {
+      elem[end[blk[s]]] = s;
+      loc[s] = end[blk[s]]++;
+    }
+  }
+  // Hopcroft's partition refinement
+  std::vector<int> work;
+  std::vector<bool> in_work(beg.size(), true);
+  for (int b = static_cast<int>(beg.size()) - 1; b >= 0; --b)
+    work.push_back(b);
+  std::vector<int> splitter, touched;
+  while (!work.empty())
+  {
+    int b = work.back();
+    work.pop_back();
+    in_work[b] = false;
+    splitter.assign(elem.begin() + beg[b], elem.begin() + end[b]);
+    for (int a = 0; a < nsym; ++a)
+    {
+      for (std::vector<int>::const_iterator i = splitter.begin(); i != splitter.end(); ++i)
+      {
+        size_t k = static_cast<size_t>(a) * N + *i;
+        for (int j = inv_beg[k]; j < inv_beg[k + 1]; ++j)
+        {
+          int s = inv[j];
+          int y = blk[s];
+          int p = beg[y] + mark[y];
+          if (loc[s] < p)
+            continue; // already marked
+          if (mark[y] == 0)
+            touched.push_back(y);
+          // move s to the marked front of block y
+          int u = elem[p];
+          elem[p] = s;
+          elem[loc[s]] = u;
+          loc[u] = loc[s];
+          loc[s] = p;
+          ++mark[y];
+        }
+      }
+      for (std::vector<int>::const_iterator i = touched.begin(); i != touched.end(); ++i)
+      {
+        int y = *i;
+        int m = mark[y];
+        mark[y] = 0;
+        if (m == end[y] - beg[y])
+          continue;
+        // split block y into the marked states z and the remaining states y
+        int z = static_cast<int>(beg.size());
+        beg.push_back(beg[y]);
+        end.push_back(beg[y] + m);
+        mark.push_back(0);
+        beg[y] += m;
+        for (int k = beg[z]; k < end[z]; ++k)
+          blk[elem[k]] = z;
+        if (in_work[y] || m <= end[y] - beg[y])
+        {
+          work.push_back(z);
+          in_work.push_back(true);
+        }
+        else
+        {
+          in_work.push_back(false);
+          work.push_back(y);
+          in_work[y] = true;
+        }
+      }
+      touched.clear();
+    }
+  }
+  // the first state of a block in depth-first order represents the block, the start state remains first
+  std::vector<DFA::State*> rep(beg.size(), NULL);
+  for (int s = 0; s < n; ++s)
+    if (rep[blk[s]] == NULL)
+      rep[blk[s]] = states[s];
+  vno_ = 0;
+  eno_ = 0;
+  DFA::State *last_state = NULL;
+  for (int s = 0; s < n; ++s)
+  {
+    DFA::State *state = states[s];
+    if (rep[blk[s]] != state)
+      continue;
+    if (last_state != NULL)
+      last_state->next = state;
+    last_state = state;
+    for (DFA::State::Edges::iterator i = state->edges.begin(); i != state->edges.end(); ++i)
+    {
+      if (i->second.second != NULL)
+        i->second.second = rep[blk[i->second.second->index]];
+#if WITH_COMPACT_DFA == -1
+      eno_ += i->second.first - i->first + 1;
+#else
+      eno_ += i->first - i->second.first + 1;
+#endif
+    }
+    ++vno_;
+  }
+  last_state->next = NULL;
+  vms_ += timer_elapsed(t);
+  DBGLOG("END minimize_dfa() %zu states", vno_);
+}
+
 void Pattern::lazy(
     const Lazyset& lazyset,
     Positions&     pos) const
@@ -1590,16 +2206,43 @@ void Pattern::trim_lazy(Positions *pos) const
 #endif
 }
 
+void Pattern::trim_lazy(Flatpos *pos) const
+{
+  if (!pos->empty() && pos->back().lazy())
+  {
+    // lazy positions are ordered last, trim them as a set
+    Positions set(pos->begin(), pos->end());
+    trim_lazy(&set);
+    pos->assign(set.begin(), set.end());
+    return;
+  }
+  // trims accept positions keeping the first only, and keeping redo (positions with accept == 0)
+  bool first = true;
+  Flatpos::iterator j = pos->begin();
+  for (Flatpos::const_iterator i = pos->begin(); i != pos->end(); ++i)
+  {
+    if (i->accept() && i->accepts() != 0)
+    {
+      if (!first)
+        continue;
+      first = false;
+    }
+    *j++ = *i;
+  }
+  pos->erase(j, pos->end());
+}
+
 void Pattern::compile_transition(
-    DFA::State *state,
-    Follow&     followpos,
-    const Map&  modifiers,
-    const Map&  lookahead,
-    Moves&      moves) const
+    DFA::State       *state,
+    const Flatfollow& followpos,
+    Flatfollow&       lazypos,
+    const Map&        modifiers,
+    const Map&        lookahead,
+    Moves&            moves) const
 {
   DBGLOG("BEGIN compile_transition()");
-  Positions::const_iterator end = state->end();
-  for (Positions::const_iterator k = state->begin(); k != end; ++k)
+  Flatpos::const_iterator end = state->end();
+  for (Flatpos::const_iterator k = state->begin(); k != end; ++k)
   {
     if (k->accept())
     {
@@ -1664,7 +2307,7 @@ void Pattern::compile_transition(
       }
       else
       {
-        Follow::const_iterator i = followpos.find(k->pos());
+        Flatfollow::const_iterator i = followpos.find(k->pos());
         if (i != followpos.end())
         {
           if (k->lazy())
@@ -1673,25 +2316,27 @@ void Pattern::compile_transition(
             if (k->greedy())
               continue;
 #endif
-            Follow::iterator j = followpos.find(*k);
-            if (j == followpos.end())
+            Flatfollow::iterator j = lazypos.find(*k);
+            if (j == lazypos.end())
             {
               // followpos is not defined for lazy pos yet, so add lazy followpos (memoization)
-              j = followpos.insert(std::pair<Position,Positions>(*k, Positions())).first;
-              for (Positions::const_iterator p = i->second.begin(); p != i->second.end(); ++p)
-                j->second.insert(/* p->lazy() || CHECKED algorithmic options: 7/31 */ p->ticked() ? *p : /* CHECKED algorithmic options: 7/31 adds too many states p->greedy() ? p->lazy(0).greedy(false) : */ p->lazy(k->lazy())); // CHECKED algorithmic options: 7/18 ticked() preserves lookahead tail at '/' and ')'
+              j = lazypos.insert(std::pair<Position,Flatpos>(*k, Flatpos())).first;
+              for (Flatpos::const_iterator p = i->second.begin(); p != i->second.end(); ++p)
+                j->second.push_back(/* p->lazy() || CHECKED algorithmic options: 7/31 */ p->ticked() ? *p : /* CHECKED algorithmic options: 7/31 adds too many states p->greedy() ? p->lazy(0).greedy(false) : */ p->lazy(k->lazy())); // CHECKED algorithmic options: 7/18 ticked() preserves lookahead tail at '/' and ')'
+              std::sort(j->second.begin(), j->second.end());
+              j->second.erase(std::unique(j->second.begin(), j->second.end()), j->second.end());
 #ifdef DEBUG
               DBGLOGN("lazy followpos(");
               DBGLOGPOS(*k);
               DBGLOGA(" ) = {");
-              for (Positions::const_iterator q = j->second.begin(); q != j->second.end(); ++q)
+              for (Flatpos::const_iterator q = j->second.begin(); q != j->second.end(); ++q)
                 DBGLOGPOS(*q);
               DBGLOGA(" }");
 #endif
             }
             i = j;
           }
-          const Positions &follow = i->second;
+          const Flatpos &follow = i->second;
           Chars chars;
           if (literal)
           {
@@ -1807,9 +2452,9 @@ void Pattern::compile_transition(
 }
 
 void Pattern::transition(
-    Moves&           moves,
-    Chars&           chars,
-    const Positions& follow) const
+    Moves&         moves,
+    Chars&         chars,
+    const Flatpos& follow) const
 {
   Moves::iterator i = moves.begin();
   Moves::iterator end = moves.end();
@@ -1975,7 +2620,11 @@ void Pattern::assemble(DFA::State *start)
   timer_type t;
   timer_start(t);
   predict_match_dfa(start);
+  reverse_dfa(start);
   export_dfa(start);
+  tabulate_dfa(start);
+  if (opt_.o && tbl_ == NULL)
+    classify_dfa(start); // byte classes index the switch jump tables of the FSM code
   compact_dfa(start);
   encode_dfa(start);
   wms_ = timer_elapsed(t);
@@ -1984,6 +2633,116 @@ void Pattern::assemble(DFA::State *start)
   DBGLOG("END assemble()");
 }
 
+void Pattern::classify_dfa(const DFA::State *start)
+{
+  DBGLOG("BEGIN classify_dfa()");
+  // refine the partition of bytes into classes of bytes that make identical transitions in all states
+  std::vector<int> ids(256 * 257, -1);
+  std::vector<int> used;
+  uint16_t target[256];
+  uint8_t cls[256];
+  Index ncl = 1;
+  for (int c = 0; c < 256; ++c)
+    bcl_[c] = 0;
+  for (const DFA::State *state = start; state; state = state->next)
+  {
+    if (state->edges.empty())
+      continue;
+    std::map<const DFA::State*,uint16_t> targets;
+    for (int c = 0; c < 256; ++c)
+      target[c] = 0;
+    for (DFA::State::Edges::const_iterator i = state->edges.begin(); i != state->edges.end(); ++i)
+    {
+#if WITH_COMPACT_DFA == -1
+      Char lo = i->first;
+      Char hi = i->second.first;
+#else
+      Char lo = i->second.first;
+      Char hi = i->first;
+#endif
+      if (is_meta(lo))
+        continue;
+      std::map<const DFA::State*,uint16_t>::iterator t = targets.find(i->second.second);
+      if (t == targets.end())
+        t = targets.insert(std::pair<const DFA::State*,uint16_t>(i->second.second, static_cast<uint16_t>(targets.size() + 1))).first;
+      for (Char c = lo; c <= hi; ++c)
+        target[c] = t->second;
+    }
+    ncl = 0;
+    for (int c = 0; c < 256; ++c)
+    {
+      int& id = ids[257 * bcl_[c] + target[c]];
+      if (id < 0)
+      {
+        id = ncl++;
+        used.push_back(257 * bcl_[c] + target[c]);
+      }
+      cls[c] = static_cast<uint8_t>(id);
+    }
+    for (std::vector<int>::const_iterator i = used.begin(); i != used.end(); ++i)
+      ids[*i] = -1;
+    used.clear();
+    memcpy(bcl_, cls, sizeof(bcl_));
+  }
+  ncl_ = ncl;
+  DBGLOG("END classify_dfa() %u classes", ncl_);
+}
+
+void Pattern::tabulate_dfa(const DFA::State *start)
+{
+  if (!opt_.d)
+    return;
+  DBGLOG("BEGIN tabulate_dfa()");
+  // a dense table is only applicable to DFAs without meta transitions and lookaheads
+  std::map<const DFA::State*,Index> rows;
+  Index nrw = 0;
+  for (const DFA::State *state = start; state; state = state->next)
+  {
+    if (!state->heads.empty() || !state->tails.empty())
+      return;
+    for (DFA::State::Edges::const_iterator i = state->edges.begin(); i != state->edges.end(); ++i)
+#if WITH_COMPACT_DFA == -1
+      if (is_meta(i->first))
+#else
+      if (is_meta(i->second.first))
+#endif
+        return;
+    rows[state] = nrw++;
+  }
+  // byte classes index the table rows, classes are not computed unless needed
+  classify_dfa(start);
+  Index width = ncl_ + 1;
+  if (static_cast<size_t>(nrw) * width > Const::TMAX)
+    return;
+  Index *table = new Index[nrw * width];
+  Index *row = table;
+  for (const DFA::State *state = start; state; state = state->next, row += width)
+  {
+    Accept accept = state->accept > Const::AMAX ? Const::AMAX : state->accept;
+    row[0] = state->redo ? 0x40000000 : accept;
+    if (state->edges.empty())
+      row[0] |= 0x80000000;
+    for (Index k = 1; k < width; ++k)
+      row[k] = Const::IMAX;
+    for (DFA::State::Edges::const_iterator i = state->edges.begin(); i != state->edges.end(); ++i)
+    {
+#if WITH_COMPACT_DFA == -1
+      Char lo = i->first;
+      Char hi = i->second.first;
+#else
+      Char lo = i->second.first;
+      Char hi = i->first;
+#endif
+      Index next = i->second.second != NULL ? rows[i->second.second] * width : Const::IMAX;
+      for (Char c = lo; c <= hi; ++c)
+        row[bcl_[c] + 1] = next;
+    }
+  }
+  tbl_ = table;
+  nrw_ = nrw;
+  DBGLOG("END tabulate_dfa() %u rows", nrw_);
+}
+
 void Pattern::compact_dfa(DFA::State *start)
 {
 #if WITH_COMPACT_DFA == -1
@@ -2319,11 +3078,26 @@ void Pattern::gencode_dfa(const DFA::State *start) const
             "#pragma clang diagnostic ignored \"-Wunused-label\"\n"
             "#endif\n\n");
         write_namespace_open(file);
+        const char *name = opt_.n.empty() ? "FSM" : opt_.n.c_str();
+        // the byte classes of the DFA index the switch jump tables of states with many transitions
+        for (const DFA::State *state = start; state; state = state->next)
+        {
+          Jumps jumps;
+          gencode_dfa_ranges(state, jumps);
+          if (!jumps.empty() && jumps.size() >= opt_.g)
+          {
+            ::fprintf(file, "static const unsigned char reflex_bcl_%s[256] = {", name);
+            for (Char c = 0; c < 256; ++c)
+              ::fprintf(file, "%s%3hhu,", (c & 0xF) ? "" : "\n  ", bcl_[c]);
+            ::fprintf(file, "\n};\n\n");
+            break;
+          }
+        }
         ::fprintf(file,
             "void reflex_code_%s(reflex::Matcher& m)\n"
             "{\n"
             "  int c0 = 0, c1 = 0;\n"
-            "  m.FSM_INIT(c1);\n", opt_.n.empty() ? "FSM" : opt_.n.c_str());
+            "  m.FSM_INIT(c1);\n", name);
         for (const DFA::State *state = start; state; state = state->next)
         {
           ::fprintf(file, "\nS%u:\n", state->index);
@@ -2374,6 +3148,8 @@ void Pattern::gencode_dfa(const DFA::State *start) const
           }
           bool read = peek;
           bool elif = false;
+          Jumps jumps; // the disjoint byte ranges of this state to search or to switch on, when the state has many transitions
+          gencode_dfa_ranges(state, jumps);
 #if WITH_COMPACT_DFA == -1
           for (DFA::State::Edges::const_reverse_iterator i = state->edges.rbegin(); i != state->edges.rend(); ++i)
           {
@@ -2392,6 +3168,8 @@ void Pattern::gencode_dfa(const DFA::State *start) const
             }
             if (!is_meta(lo))
             {
+              if (!jumps.empty())
+                break;
               DFA::State::Edges::const_reverse_iterator j = i;
               if (target_index == Const::IMAX && (++j == state->edges.rend() || is_meta(j->second.first)))
                 break;
@@ -2518,21 +3296,22 @@ void Pattern::gencode_dfa(const DFA::State *start) const
               } while (++lo <= hi);
             }
           }
-          for (DFA::State::Edges::const_iterator i = state->edges.begin(); i != state->edges.end(); ++i)
+          if (read)
+          {
+            if (prev)
+              ::fprintf(file, "  c0 = c1, c1 = m.FSM_CHAR();\n");
+            else
+              ::fprintf(file, "  c1 = m.FSM_CHAR();\n");
+            read = false;
+          }
+          // the meta edges sort after the byte edges and were handled before the byte edges, the byte edges are searched with jumps when non-empty
+          for (DFA::State::Edges::const_iterator i = state->edges.begin(); i != state->edges.end() && jumps.empty(); ++i)
           {
             Char hi = i->first;
             Char lo = i->second.first;
             Index target_index = Const::IMAX;
             if (i->second.second != NULL)
               target_index = i->second.second->index;
-            if (read)
-            {
-              if (prev)
-                ::fprintf(file, "  c0 = c1, c1 = m.FSM_CHAR();\n");
-              else
-                ::fprintf(file, "  c1 = m.FSM_CHAR();\n");
-              read = false;
-            }
             if (!is_meta(lo))
             {
               DFA::State::Edges::const_iterator j = i;
@@ -2572,6 +3351,8 @@ void Pattern::gencode_dfa(const DFA::State *start) const
             }
           }
 #endif
+          if (!jumps.empty())
+            gencode_dfa_jumps(file, jumps);
           if (peek)
             ::fprintf(file, "  return m.FSM_HALT(c1);\n");
           else
@@ -2588,6 +3369,142 @@ void Pattern::gencode_dfa(const DFA::State *start) const
   }
 }
 
+void Pattern::gencode_dfa_ranges(const DFA::State *state, Jumps& jumps) const
+{
+  // compacted edges may overlap, the first edge tested by the generated code takes precedence
+  Index target[256];
+  bool done[256];
+  std::fill(done, done + 256, false);
+#if WITH_COMPACT_DFA == -1
+  for (DFA::State::Edges::const_reverse_iterator i = state->edges.rbegin(); i != state->edges.rend(); ++i)
+  {
+    Char lo = i->first;
+    Char hi = i->second.first;
+#else
+  for (DFA::State::Edges::const_iterator i = state->edges.begin(); i != state->edges.end(); ++i)
+  {
+    Char hi = i->first;
+    Char lo = i->second.first;
+#endif
+    if (is_meta(lo))
+      continue;
+    Index target_index = i->second.second != NULL ? i->second.second->index : Const::IMAX;
+    for (Char c = lo; c <= hi; ++c)
+    {
+      if (!done[c])
+      {
+        target[c] = target_index;
+        done[c] = true;
+      }
+    }
+  }
+  for (Char c = 0; c <= 0xFF; ++c)
+  {
+    if (!done[c] || target[c] == Const::IMAX)
+      continue;
+    if (!jumps.empty() && jumps.back().second.first + 1 == c && jumps.back().second.second == target[c])
+      jumps.back().second.first = c;
+    else
+      jumps.push_back(std::pair<Char,std::pair<Char,Index> >(c, std::pair<Char,Index>(c, target[c])));
+  }
+  // without option g only states with Const::JMIN or more transitions are coded with a switch
+  if (jumps.size() < (opt_.g > 0 ? Const::BMIN : Const::JMIN))
+    jumps.clear();
+}
+
+void Pattern::gencode_dfa_jumps(FILE *file, const Jumps& jumps) const
+{
+  if (jumps.size() < opt_.g)
+  {
+    gencode_dfa_search(file, jumps, 0, jumps.size(), -1, 0xFF, 1);
+    return;
+  }
+  // switch on the byte class of c1, all bytes of a class make the same transition in this state
+  std::vector<std::pair<Index,std::vector<uint8_t> > > cases;
+  bool done[256];
+  std::fill(done, done + 256, false);
+  for (Jumps::const_iterator i = jumps.begin(); i != jumps.end(); ++i)
+  {
+    size_t k = 0;
+    while (k < cases.size() && cases[k].first != i->second.second)
+      ++k;
+    if (k == cases.size())
+      cases.push_back(std::pair<Index,std::vector<uint8_t> >(i->second.second, std::vector<uint8_t>()));
+    for (Char c = i->first; c <= i->second.first; ++c)
+    {
+      if (!done[bcl_[c]])
+      {
+        cases[k].second.push_back(bcl_[c]);
+        done[bcl_[c]] = true;
+      }
+    }
+  }
+  ::fprintf(file, "  if (c1 >= 0) switch (reflex_bcl_%s[c1])\n  {\n", opt_.n.empty() ? "FSM" : opt_.n.c_str());
+  for (std::vector<std::pair<Index,std::vector<uint8_t> > >::const_iterator i = cases.begin(); i != cases.end(); ++i)
+  {
+    ::fprintf(file, "   ");
+    for (size_t k = 0; k < i->second.size(); ++k)
+    {
+      if (k > 0 && k % 8 == 0)
+        ::fprintf(file, "\n   ");
+      ::fprintf(file, " case %u:", i->second[k]);
+    }
+    ::fprintf(file, " goto S%u;\n", i->first);
+  }
+  ::fprintf(file, "  }\n");
+}
+
+void Pattern::gencode_dfa_search(FILE *file, const Jumps& jumps, size_t lo, size_t hi, int min, int max, int nest) const
+{
+  if (hi - lo > 2)
+  {
+    // binary search on the lower bounds of the byte ranges, min <= c1 <= max
+    size_t mid = (lo + hi) / 2;
+    int pivot = jumps[mid].first;
+    ::fprintf(file, "%*sif (c1 < ", 2*nest, "");
+    print_char(file, pivot);
+    ::fprintf(file, ")\n%*s{\n", 2*nest, "");
+    gencode_dfa_search(file, jumps, lo, mid, min, pivot - 1, nest + 1);
+    ::fprintf(file, "%*s}\n%*selse\n%*s{\n", 2*nest, "", 2*nest, "", 2*nest, "");
+    gencode_dfa_search(file, jumps, mid, hi, pivot, max, nest + 1);
+    ::fprintf(file, "%*s}\n", 2*nest, "");
+    return;
+  }
+  for (size_t i = lo; i < hi; ++i)
+  {
+    int from = jumps[i].first;
+    int to = jumps[i].second.first;
+    ::fprintf(file, "%*s", 2*nest, "");
+    if (from == to)
+    {
+      ::fprintf(file, "if (c1 == ");
+      print_char(file, from);
+      ::fprintf(file, ") ");
+    }
+    else if (from > min && to < max)
+    {
+      ::fprintf(file, "if (");
+      print_char(file, from);
+      ::fprintf(file, " <= c1 && c1 <= ");
+      print_char(file, to);
+      ::fprintf(file, ") ");
+    }
+    else if (from > min)
+    {
+      ::fprintf(file, "if (");
+      print_char(file, from);
+      ::fprintf(file, " <= c1) ");
+    }
+    else if (to < max)
+    {
+      ::fprintf(file, "if (c1 <= ");
+      print_char(file, to);
+      ::fprintf(file, ") ");
+    }
+    ::fprintf(file, "goto S%u;\n", jumps[i].second.second);
+  }
+}
+
 void Pattern::check_dfa_closure(const DFA::State *state, int nest, bool& peek, bool& prev) const
 {
   if (nest > 5)
@@ -2724,7 +3641,7 @@ void Pattern::export_dfa(const DFA::State *start) const
           size_t k = 1;
           size_t n = std::sqrt(state->size()) + 0.5;
           const char *sep = "";
-          for (Positions::const_iterator i = state->begin(); i != state->end(); ++i)
+          for (Flatpos::const_iterator i = state->begin(); i != state->end(); ++i)
           {
             ::fprintf(file, "%s", sep);
             if (i->accept())
@@ -2921,6 +3838,8 @@ void Pattern::export_code() const
         ::fprintf(file, "};\n\n");
         if (opt_.p)
           write_predictor(file);
+        if (tbl_ != NULL)
+          write_table(file);
         write_namespace_close(file);
         if (file != stdout)
           ::fclose(file);
@@ -2972,9 +3891,15 @@ void Pattern::predict_match_dfa(DFA::State *start)
   std::memset(bit_, 0xFF, sizeof(bit_));
   std::memset(pmh_, 0xFF, sizeof(pmh_));
   std::memset(pma_, 0xFF, sizeof(pma_));
+  nbp_ = 0;
+  wbl_ = 0;
   if (state != NULL && state->accept == 0)
   {
     gen_predict_match(state);
+    if (len_ == 0 && min_ > 0)
+      gen_predict_nibbles(state);
+    if (len_ == 0 && min_ == 8)
+      gen_predict_match_wide(state);
 #ifdef DEBUG
     for (Char i = 0; i < 256; ++i)
     {
@@ -3128,10 +4053,331 @@ void Pattern::gen_predict_match_transitions(size_t level, DFA::State *state, ORa
   }
 }
 
+void Pattern::gen_predict_match_wide(DFA::State *start)
+{
+  // the 64-bit bitap array covers the first 9 to 64 bytes of the patterns, the DFA states are visited level by level
+  std::memset(wbp_, 0xFF, sizeof(wbp_));
+  std::set<DFA::State*> states;
+  states.insert(start);
+  size_t limit = 64;
+  size_t edges = 0;
+  for (size_t level = 0; level < limit && !states.empty(); ++level)
+  {
+    std::set<DFA::State*> next_states;
+    for (std::set<DFA::State*>::const_iterator state = states.begin(); state != states.end() && level < limit; ++state)
+    {
+      if ((*state)->accept != 0)
+      {
+        limit = level;
+        break;
+      }
+      for (DFA::State::Edges::const_iterator edge = (*state)->edges.begin(); edge != (*state)->edges.end(); ++edge)
+      {
+#if WITH_COMPACT_DFA == -1
+        Char lo = edge->first;
+        Char hi = edge->second.first;
+#else
+        Char lo = edge->second.first;
+        Char hi = edge->first;
+#endif
+        // stop at anchors and word boundaries and limit the work, then the levels before are complete
+        if (is_meta(lo) || ++edges > Const::TMAX / 16)
+        {
+          limit = level;
+          break;
+        }
+        DFA::State *next = edge->second.second;
+        if (next == NULL)
+          limit = level + 1;
+        else
+          next_states.insert(next);
+        while (lo <= hi)
+          wbp_[lo++] &= ~(1ULL << level);
+      }
+    }
+    states.swap(next_states);
+  }
+  if (limit > 8)
+  {
+    wbl_ = limit;
+    for (Char i = 0; i < 256; ++i)
+      wbp_[i] &= (limit < 64 ? (1ULL << limit) : 0ULL) - 1;
+  }
+  DBGLOGN("wide bitap length = %zu", wbl_);
+}
+
+void Pattern::gen_predict_nibbles(DFA::State *start)
+{
+  // the first 1 to 3 bytes of a match are on a path of byte transitions from the start state, distribute the paths over 8 buckets
+  std::vector<Char> path;
+  std::vector<Char> paths;
+  nbp_ = min_ < 3 ? min_ : 3;
+  if (!gen_predict_nibbles_paths(start, 0, path, paths) || paths.empty())
+  {
+    nbp_ = 0;
+    return;
+  }
+  size_t n = paths.size() / (2 * nbp_);
+  // the paths should spell a limited number of literals, because wide character classes such as [a-z] match too often
+  size_t literals = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t k = 1;
+    for (size_t j = 0; j < nbp_; ++j)
+      k *= paths[2 * (i * nbp_ + j) + 1] - paths[2 * (i * nbp_ + j)] + 1;
+    literals += k;
+  }
+  DBGLOGN("nibble paths = %zu literals = %zu", n, literals);
+  if (literals > 16 * Const::NMAX)
+  {
+    nbp_ = 0;
+    return;
+  }
+  std::memset(nib_, 0, sizeof(nib_));
+  for (size_t i = 0; i < n; ++i)
+  {
+    Pred bucket = 1 << (8 * i / n);
+    for (size_t j = 0; j < nbp_; ++j)
+    {
+      for (Char c = paths[2 * (i * nbp_ + j)]; c <= paths[2 * (i * nbp_ + j) + 1]; ++c)
+      {
+        nib_[j][c & 0x0f] |= bucket;
+        nib_[j][16 + (c >> 4)] |= bucket;
+      }
+    }
+  }
+}
+
+bool Pattern::gen_predict_nibbles_paths(DFA::State *state, size_t level, std::vector<Char>& path, std::vector<Char>& paths)
+{
+  if (level >= nbp_)
+  {
+    if (paths.size() >= 2 * nbp_ * Const::NMAX)
+      return false;
+    paths.insert(paths.end(), path.begin(), path.end());
+    return true;
+  }
+  if (state == NULL)
+  {
+    // any byte may follow
+    path.push_back(0x00);
+    path.push_back(0xff);
+    bool ok = gen_predict_nibbles_paths(NULL, level + 1, path, paths);
+    path.resize(path.size() - 2);
+    return ok;
+  }
+  for (DFA::State::Edges::const_iterator edge = state->edges.begin(); edge != state->edges.end(); ++edge)
+  {
+    if (is_meta(edge->first))
+    {
+      // an anchor or boundary may be followed by any byte
+      if (level > 0)
+      {
+        path.push_back(0x00);
+        path.push_back(0xff);
+        bool ok = gen_predict_nibbles_paths(NULL, level + 1, path, paths);
+        path.resize(path.size() - 2);
+        return ok;
+      }
+      break;
+    }
+    path.push_back(edge->first);
+    path.push_back(edge->second.first);
+    bool ok = gen_predict_nibbles_paths(edge->second.second, level + 1, path, paths);
+    path.resize(path.size() - 2);
+    if (!ok)
+      return false;
+  }
+  return true;
+}
+
+void Pattern::reverse_dfa(const DFA::State *start)
+{
+  if (len_ > 0 || min_ == 0 || aho_ != NULL)
+    return;
+  DBGLOG("BEGIN reverse_dfa()");
+  // only applicable to DFAs without meta transitions and lookaheads, number the states breadth first
+  std::map<const DFA::State*,size_t> index;
+  std::vector<const DFA::State*> states(1, start);
+  index[start] = 0;
+  for (size_t i = 0; i < states.size(); ++i)
+  {
+    const DFA::State *state = states[i];
+    if (!state->heads.empty() || !state->tails.empty() || states.size() > Const::NMAX * 16)
+      return;
+    for (DFA::State::Edges::const_iterator edge = state->edges.begin(); edge != state->edges.end(); ++edge)
+    {
+#if WITH_COMPACT_DFA == -1
+      Char lo = edge->first;
+#else
+      Char lo = edge->second.first;
+#endif
+      if (is_meta(lo))
+        return;
+      const DFA::State *next = edge->second.second;
+      if (next != NULL && index.insert(std::pair<const DFA::State*,size_t>(next, states.size())).second)
+        states.push_back(next);
+    }
+  }
+  // the byte of the incoming edges of each state, or -1 when a state is entered on more than one byte
+  std::vector<int> label(states.size(), -2);
+  label[0] = -1;
+  for (size_t i = 0; i < states.size(); ++i)
+  {
+    for (DFA::State::Edges::const_iterator edge = states[i]->edges.begin(); edge != states[i]->edges.end(); ++edge)
+    {
+#if WITH_COMPACT_DFA == -1
+      Char lo = edge->first;
+      Char hi = edge->second.first;
+#else
+      Char lo = edge->second.first;
+      Char hi = edge->first;
+#endif
+      if (edge->second.second == NULL)
+        continue;
+      int& b = label[index[edge->second.second]];
+      if (lo != hi || (b != -2 && b != static_cast<int>(lo)))
+        b = -1;
+      else
+        b = static_cast<int>(lo);
+    }
+  }
+  // find a state d entered on one byte b such that all matches pass through d, the part of the DFA before d is the prefix part
+  std::vector<size_t> part;
+  std::vector<bool> seen;
+  size_t d;
+  for (d = 1; d < states.size(); ++d)
+  {
+    if (label[d] < 0)
+      continue;
+    part.assign(1, 0);
+    seen.assign(states.size(), false);
+    seen[0] = true;
+    seen[d] = true;
+    bool ok = true;
+    for (size_t i = 0; ok && i < part.size(); ++i)
+    {
+      const DFA::State *state = states[part[i]];
+      if (state->accept > 0 || state->redo || part.size() > 64)
+      {
+        ok = false;
+        break;
+      }
+      for (DFA::State::Edges::const_iterator edge = state->edges.begin(); edge != state->edges.end(); ++edge)
+      {
+        if (edge->second.second == NULL)
+          continue;
+        size_t k = index[edge->second.second];
+        if (!seen[k])
+        {
+          seen[k] = true;
+          part.push_back(k);
+        }
+      }
+    }
+    if (!ok)
+      continue;
+    // the first byte of the factor should not occur in the prefix part, so a backward scan never passes a previous factor
+    std::vector<size_t> bit(states.size(), 0);
+    for (size_t i = 0; i < part.size(); ++i)
+      bit[part[i]] = i;
+    ReverseDFA *rev = new ReverseDFA;
+    std::vector<uint64_t> pred(256 * part.size(), 0);
+    uint64_t last = 0;
+    for (Char c = 0; c < 256; ++c)
+      rev->part[c] = false;
+    for (size_t i = 0; i < part.size(); ++i)
+    {
+      for (DFA::State::Edges::const_iterator edge = states[part[i]]->edges.begin(); edge != states[part[i]]->edges.end(); ++edge)
+      {
+#if WITH_COMPACT_DFA == -1
+        Char lo = edge->first;
+        Char hi = edge->second.first;
+#else
+        Char lo = edge->second.first;
+        Char hi = edge->first;
+#endif
+        if (edge->second.second == NULL)
+          continue;
+        size_t k = index[edge->second.second];
+        if (k == d)
+        {
+          last |= 1ULL << i;
+          continue;
+        }
+        for (Char c = lo; c <= hi; ++c)
+        {
+          pred[256 * bit[k] + c] |= 1ULL << i;
+          rev->part[c] = true;
+        }
+      }
+    }
+    if (last == 0 || rev->part[label[d]])
+    {
+      delete rev;
+      continue;
+    }
+    // the factor continues with the bytes of the states after d that have one transition on one byte
+    rev->factor.push_back(static_cast<char>(label[d]));
+    const DFA::State *state = states[d];
+    while (state->accept == 0 && !state->redo && state->edges.size() == 1 && rev->factor.size() < 255)
+    {
+      const DFA::State::Edges::const_iterator edge = state->edges.begin();
+      if (edge->first != edge->second.first || edge->second.second == NULL)
+        break;
+      rev->factor.push_back(static_cast<char>(edge->first));
+      state = edge->second.second;
+    }
+    // subset construction of the reverse DFA, the start state is the set of prefix part states with a transition to d
+    std::map<uint64_t,uint8_t> ids;
+    std::vector<uint64_t> sets(1, 0);
+    ids[last] = 1;
+    sets.push_back(last);
+    rev->next.assign(256, 0);
+    rev->accept.assign(1, 0);
+    for (size_t k = 1; k < sets.size(); ++k)
+    {
+      rev->accept.push_back(sets[k] & 1);
+      for (Char c = 0; c < 256; ++c)
+      {
+        uint64_t set = 0;
+        for (size_t i = 0; i < part.size(); ++i)
+          if (sets[k] & (1ULL << i))
+            set |= pred[256 * i + c];
+        uint8_t id = 0;
+        if (set != 0)
+        {
+          std::map<uint64_t,uint8_t>::iterator j = ids.find(set);
+          if (j == ids.end())
+          {
+            if (sets.size() > ReverseDFA::MAXS)
+              break;
+            j = ids.insert(std::pair<uint64_t,uint8_t>(set, static_cast<uint8_t>(sets.size()))).first;
+            sets.push_back(set);
+          }
+          id = j->second;
+        }
+        rev->next.push_back(id);
+      }
+      if (rev->next.size() < 256 * (k + 1))
+        break;
+    }
+    if (rev->next.size() < 256 * sets.size())
+    {
+      delete rev;
+      continue;
+    }
+    DBGLOGN("reverse DFA factor = '%s' states = %zu", rev->factor.c_str(), sets.size() - 1);
+    rev_ = rev;
+    break;
+  }
+  DBGLOG("END reverse_dfa()");
+}
+
 void Pattern::write_predictor(FILE *file) const
 {
-  ::fprintf(file, "extern const reflex::Pattern::Pred reflex_pred_%s[%zu] = {", opt_.n.empty() ? "FSM" : opt_.n.c_str(), 2 + len_ + (min_ > 1 && len_ == 0) * 256 + (min_ > 0) * Const::HASH);
-  ::fprintf(file, "\n  %3hhu,%3hhu,", static_cast<uint8_t>(len_), (static_cast<uint8_t>(min_ | (one_ << 4))));
+  ::fprintf(file, "extern const reflex::Pattern::Pred reflex_pred_%s[%zu] = {", opt_.n.empty() ? "FSM" : opt_.n.c_str(), 2 + len_ + (min_ > 1 && len_ == 0) * 256 + (min_ > 0) * Const::HASH + 32 * nbp_);
+  ::fprintf(file, "\n  %3hhu,%3hhu,", static_cast<uint8_t>(len_), (static_cast<uint8_t>(min_ | (one_ << 4) | (nbp_ << 5))));
   for (size_t i = 0; i < len_; ++i)
     ::fprintf(file, "%s%3hhu,", ((i + 2) & 0xF) ? "" : "\n  ", static_cast<uint8_t>(pre_[i]));
   if (min_ > 0)
@@ -3151,10 +4397,50 @@ void Pattern::write_predictor(FILE *file) const
       for (Hash i = 0; i < Const::HASH; ++i)
         ::fprintf(file, "%s%3hhu,", (i & 0xF) ? "" : "\n  ", static_cast<uint8_t>(~pma_[i]));
     }
+    for (size_t i = 0; i < 32 * nbp_; ++i)
+      ::fprintf(file, "%s%3hhu,", (i & 0xF) ? "" : "\n  ", static_cast<uint8_t>(nib_[i / 32][i % 32]));
   }
   ::fprintf(file, "\n};\n\n");
 }
 
+void Pattern::write_table(FILE *file) const
+{
+  // the dense transition table and byte classes for reflex::StaticMatcher, returned for the opcode table reflex_code_NAME only
+  const char *name = opt_.n.empty() ? "FSM" : opt_.n.c_str();
+  size_t n = static_cast<size_t>(nrw_) * (ncl_ + 1);
+  ::fprintf(file, "struct reflex_tables_%s {\n  static const reflex::Pattern::Index *table(const reflex::Pattern::Opcode *code, const uint8_t*& bcl)\n  {\n", name);
+  ::fprintf(file, "    static const reflex::Pattern::Index tbl[%zu] = {", n);
+  for (size_t i = 0; i < n; ++i)
+    ::fprintf(file, "%s0x%08X,", (i % (ncl_ + 1)) ? " " : "\n      ", tbl_[i]);
+  ::fprintf(file, "\n    };\n    static const uint8_t cls[256] = {");
+  for (Char i = 0; i < 256; ++i)
+    ::fprintf(file, "%s%3hhu,", (i & 0xF) ? "" : "\n      ", bcl_[i]);
+  ::fprintf(file, "\n    };\n    if (code != reflex_code_%s)\n      return NULL;\n    bcl = cls;\n    return tbl;\n  }\n};\n\n", name);
+}
+
+void Pattern::gen_predictor(std::vector<Pred>& pred) const
+{
+  // same layout as the reflex_pred_ array written by write_predictor()
+  pred.clear();
+  pred.push_back(static_cast<Pred>(len_));
+  pred.push_back(static_cast<Pred>(min_ | (one_ << 4) | (nbp_ << 5)));
+  pred.insert(pred.end(), pre_, pre_ + len_);
+  if (min_ > 0)
+  {
+    if (min_ > 1 && len_ == 0)
+      for (Char i = 0; i < 256; ++i)
+        pred.push_back(static_cast<Pred>(~bit_[i]));
+    if (min_ >= 4)
+      for (Hash i = 0; i < Const::HASH; ++i)
+        pred.push_back(static_cast<Pred>(~pmh_[i]));
+    else
+      for (Hash i = 0; i < Const::HASH; ++i)
+        pred.push_back(static_cast<Pred>(~pma_[i]));
+    for (size_t i = 0; i < nbp_; ++i)
+      pred.insert(pred.end(), nib_[i], nib_[i] + 32);
+  }
+}
+
 void Pattern::write_namespace_open(FILE *file) const
 {
   if (opt_.z.empty())
@@ -3185,4 +4471,189 @@ void Pattern::write_namespace_close(FILE *file) const
   ::fprintf(file, "} // namespace %s\n\n", s.substr(i).c_str());
 }
 
+size_t Pattern::bytes() const
+{
+  size_t n = sizeof(Pattern) + rex_.capacity() + sizeof(Location) * end_.capacity() + acc_.capacity() / 8;
+  n += sizeof(Opcode) * nop_ + sizeof(Index) * table_words();
+  if (lnf_ != NULL)
+  {
+    // estimate a std::map node as the key and value plus three pointers and a color
+    const size_t node = 4 * sizeof(void*);
+    n += sizeof(LazyNFA) + sizeof(Position) * lnf_->start.capacity();
+    for (Flatfollow::const_iterator i = lnf_->followpos.begin(); i != lnf_->followpos.end(); ++i)
+      n += node + sizeof(Position) + sizeof(Flatpos) + sizeof(Position) * i->second.capacity();
+    for (Map::const_iterator i = lnf_->modifiers.begin(); i != lnf_->modifiers.end(); ++i)
+      n += node + sizeof(int) + sizeof(Locations) + (node + sizeof(Location)) * i->second.size();
+  }
+  if (aho_ != NULL)
+    n += sizeof(AhoCorasick) + sizeof(AhoCorasick::State) * aho_->state.capacity() + sizeof(AhoCorasick::Edge) * aho_->edge.capacity() + sizeof(uint32_t) * aho_->dense.capacity() + sizeof(Accept) * aho_->accept.capacity();
+  if (rev_ != NULL)
+    n += sizeof(ReverseDFA) + rev_->factor.capacity() + rev_->next.capacity() + rev_->accept.capacity();
+  return n;
+}
+
+/*
+  Compiled pattern file layout, words and locations are 32 bit in native byte order:
+  - header of eight words: MAGIC, FORMAT, opcodes, predict bytes, subpatterns, regex bytes, nodes, edges
+  - opcode table words, memory mapped and used in place by the reflex::Matcher engine
+  - subpattern end locations
+  - predict match array bytes, same layout as the reflex_pred_ array of generated code
+  - subpattern reachable bytes
+  - regex string bytes
+*/
+
+bool Pattern::save(const char *filename) const
+{
+  if (opc_ == NULL || nop_ == 0)
+    return false;
+  std::vector<Pred> pred;
+  gen_predictor(pred);
+  uint32_t header[8] = {
+    Const::MAGIC,
+    Const::FORMAT,
+    nop_,
+    static_cast<uint32_t>(pred.size()),
+    static_cast<uint32_t>(end_.size()),
+    static_cast<uint32_t>(rex_.size()),
+    static_cast<uint32_t>(vno_),
+    static_cast<uint32_t>(eno_)
+  };
+  std::vector<uint32_t> ends(end_.begin(), end_.end());
+  std::vector<uint8_t> reachable(acc_.begin(), acc_.end());
+  reachable.resize(end_.size(), true);
+  FILE *file = NULL;
+  if (fopen_s(&file, filename, "wb") != 0)
+    return false;
+  bool ok =
+    ::fwrite(header, sizeof(header), 1, file) == 1 &&
+    ::fwrite(opc_, sizeof(Opcode), nop_, file) == nop_ &&
+    (ends.empty() || ::fwrite(&ends[0], sizeof(uint32_t), ends.size(), file) == ends.size()) &&
+    ::fwrite(&pred[0], 1, pred.size(), file) == pred.size() &&
+    (reachable.empty() || ::fwrite(&reachable[0], 1, reachable.size(), file) == reachable.size()) &&
+    ::fwrite(rex_.data(), 1, rex_.size(), file) == rex_.size();
+  return ::fclose(file) == 0 && ok;
+}
+
+bool Pattern::load_mapped(const char *filename)
+{
+  clear();
+  size_t size = 0;
+  const void *data = NULL;
+#if (defined(__WIN32__) || defined(_WIN32) || defined(WIN32) || defined(_WIN64) || defined(__BORLANDC__)) && !defined(__CYGWIN__) && !defined(__MINGW32__) && !defined(__MINGW64__)
+  // no mmap(): read the file into memory instead
+  FILE *file = NULL;
+  if (fopen_s(&file, filename, "rb") != 0)
+    return false;
+  struct _stat st;
+  if (_fstat(_fileno(file), &st) == 0 && st.st_size >= 32 && st.st_size <= 0xFFFFFFFFLL)
+  {
+    size = static_cast<size_t>(st.st_size);
+    uint32_t *words = new uint32_t[(size + 3) / 4];
+    if (::fread(words, 1, size, file) == size)
+      data = words;
+    else
+      delete[] words;
+  }
+  ::fclose(file);
+#else
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && st.st_size >= 32 && static_cast<uint64_t>(st.st_size) <= 0xFFFFFFFFULL)
+  {
+    size = static_cast<size_t>(st.st_size);
+    void *addr = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED)
+      data = addr;
+  }
+  ::close(fd);
+#endif
+  if (data == NULL)
+    return false;
+  map_ = data;
+  mms_ = size;
+  const uint32_t *header = static_cast<const uint32_t*>(data);
+  uint64_t nop = header[2];
+  uint64_t npr = header[3];
+  uint64_t nsub = header[4];
+  uint64_t nrex = header[5];
+  if (header[0] != Const::MAGIC || header[1] != Const::FORMAT || nop == 0 || npr < 2 || size != 32 + 4 * nop + 4 * nsub + npr + nsub + nrex)
+  {
+    unmap();
+    return false;
+  }
+  const Opcode *code = header + 8;
+  const uint32_t *ends = code + nop;
+  const uint8_t *pred = reinterpret_cast<const uint8_t*>(ends + nsub);
+  const uint8_t *reachable = pred + npr;
+  const char *regex = reinterpret_cast<const char*>(reachable + nsub);
+  // the predict match array should be consistent with its prefix length and min length
+  size_t len = pred[0];
+  size_t min = pred[1] & 0x0f;
+  size_t nbp = (pred[1] >> 5) & 0x03;
+  if (npr != 2 + len + (min > 1 && len == 0) * 256 + (min > 0) * Const::HASH + (min > 0) * 32 * nbp)
+  {
+    unmap();
+    return false;
+  }
+  // subpattern end locations should be ascending locations in the regex string
+  for (uint64_t i = 0; i < nsub; ++i)
+  {
+    if (ends[i] > nrex || (i > 0 && ends[i] < ends[i - 1]))
+    {
+      unmap();
+      return false;
+    }
+  }
+  // the matcher follows the opcodes without bounds checks: jumps should be in range and the last state should end with a GOTO on 0xFF or HALT
+  bool last = false;
+  for (uint64_t i = 0; i < nop; ++i)
+  {
+    Opcode opcode = code[i];
+    last = false;
+    if (!is_opcode_goto(opcode) && (opcode >> 24) >= 0xFB)
+      continue; // TAKE, REDO, TAIL, HEAD
+    Index jump = index_of(opcode);
+    if (jump == Const::LONG)
+    {
+      if (++i >= nop)
+        break;
+      jump = long_index_of(code[i]);
+    }
+    if (jump != Const::HALT && jump >= nop)
+      break;
+    last = !is_opcode_meta(opcode) && ((opcode >> 16) & 0xFF) == 0xFF;
+  }
+  if (!last)
+  {
+    unmap();
+    return false;
+  }
+  opc_ = code;
+  init(NULL, pred);
+  nop_ = static_cast<Index>(nop);
+  rex_.assign(regex, static_cast<size_t>(nrex));
+  end_.assign(ends, ends + nsub);
+  acc_.assign(reachable, reachable + nsub);
+  vno_ = header[6];
+  eno_ = header[7];
+  pms_ = 0.0;
+  vms_ = 0.0;
+  ems_ = 0.0;
+  wms_ = 0.0;
+  return true;
+}
+
+void Pattern::unmap()
+{
+#if (defined(__WIN32__) || defined(_WIN32) || defined(WIN32) || defined(_WIN64) || defined(__BORLANDC__)) && !defined(__CYGWIN__) && !defined(__MINGW32__) && !defined(__MINGW64__)
+  delete[] static_cast<const uint32_t*>(map_);
+#else
+  ::munmap(const_cast<void*>(map_), mms_);
+#endif
+  map_ = NULL;
+  mms_ = 0;
+}
+
 } // namespace reflex
@@ -83,11 +83,13 @@ static const char *options_table[] = {
   "indent",
   "input",
   "interactive",
+  "jump_tables",
   "lex",
   "lex_compat",
   "lexer",
   "main",
   "matcher",
+  "minimize",
   "namespace",
   "never_interactive",
   "noarray",
@@ -120,6 +122,7 @@ static const char *options_table[] = {
   "reentrant",
   "regexp_file",
   "stack",
+  "static",
   "stdinit",
   "stdout",
   "tables_file",
@@ -548,6 +551,14 @@ void Reflex::help(const char *message, const char *arg)
                 generate full scanner with FSM opcode tables\n\
         -F, --fast\n\
                 generate fast scanner with FSM code\n\
+        --jump-tables[=N]\n\
+                with --fast: generate binary search code for states with 4 or\n\
+                more transitions and switch jump tables for states with N or\n\
+                more transitions, where N=16 by default\n\
+        --static\n\
+                generate full scanner with static dense transition tables\n\
+        --minimize\n\
+                minimize the FSM of each start condition\n\
         -i, --case-insensitive\n\
                 ignore case in patterns\n\
         -I, --interactive, --always-interactive\n\
@@ -1677,6 +1688,30 @@ void Reflex::write()
   }
   if (!options["bison_complete"].empty())
     options["bison_cc"] = "true";
+  if (!options["static"].empty())
+  {
+    if (!options["matcher"].empty())
+    {
+      warning("option --static requires the default RE/flex matcher, ignoring --static");
+      options["static"].clear();
+    }
+    else if (!options["fast"].empty())
+    {
+      warning("option --static cannot be combined with --fast, ignoring --static");
+      options["static"].clear();
+    }
+    else if (options["tables_file"] == "true" && conditions.size() > 1)
+    {
+      warning("option --static requires one tables file for all start conditions, ignoring --static");
+      options["static"].clear();
+    }
+    else
+    {
+      options["full"] = "true";
+      library->file = "reflex/staticmatcher.h";
+      library->matcher = "reflex::StaticMatcher<reflex_tables> ";
+    }
+  }
   if (!options["namespace"].empty())
     undot_namespace(options["namespace"]);
   if (!options["bison_cc_namespace"].empty())
@@ -1961,6 +1996,19 @@ void Reflex::write_class()
   if (!options["noindent"].empty())
     *out << "#define WITH_NO_INDENT\n";
   *out << "#include <" << library->file << ">\n";
+  if (!options["static"].empty())
+  {
+    // declare the static dense tables of the start conditions, defined after the tables are generated
+    *out << "\n";
+    if (!options["namespace"].empty())
+      write_namespace_open();
+    *out <<
+      "struct reflex_tables {\n"
+      "  static const reflex::Pattern::Index *table(const reflex::Pattern::Opcode *code, const uint8_t*& bcl);\n"
+      "};\n";
+    if (!options["namespace"].empty())
+      write_namespace_close();
+  }
   const char *matcher = library->matcher;
   std::string lex = options["lex"];
   std::string token_type = options["token_type"].empty() ? "int" : options["token_type"];
@@ -2648,7 +2696,10 @@ void Reflex::write_lexer()
       else
       {
         write_regex(&conditions[start], patterns[start]);
-        *out << "  static const reflex::Pattern PATTERN_" << conditions[start] << "(REGEX_" << conditions[start] << ");\n";
+        *out << "  static const reflex::Pattern PATTERN_" << conditions[start] << "(REGEX_" << conditions[start];
+        if (!options["minimize"].empty())
+          *out << ", \"h\"";
+        *out << ");\n";
       }
     }
     else
@@ -3041,6 +3092,8 @@ void Reflex::stats()
   }
   else
   {
+    std::string tables; // file with the tables of the last start condition
+    std::vector<std::string> statics; // start conditions with static dense tables
     for (Start start = 0; start < conditions.size(); ++start)
     {
       std::string option = "r";
@@ -3052,18 +3105,39 @@ void Reflex::stats()
       else if (!options["graphs_file"].empty())
         option.append(";f=").append(start > 0 ? "+" : "").append(file_ext(options["graphs_file"], "gv"));
       if (!options["fast"].empty())
+      {
         option.append(";o");
+        if (options["jump_tables"] == "true")
+          option.append(";g");
+        else if (!options["jump_tables"].empty())
+          option.append(";g=").append(options["jump_tables"]);
+      }
       if (!options["find"].empty())
         option.append(";p");
+      if (!options["minimize"].empty())
+        option.append(";h");
+      if (!options["static"].empty())
+        option.append(";d");
       if (options["tables_file"] == "true")
+      {
         option.append(";f=reflex.").append(conditions[start]).append(".cpp");
+        tables = std::string("reflex.").append(conditions[start]).append(".cpp");
+      }
       else if (!options["tables_file"].empty())
+      {
         option.append(";f=").append(start > 0 ? "+" : "").append(file_ext(options["tables_file"], "cpp"));
+        tables = options["tables_file"];
+      }
       if ((!options["full"].empty() || !options["fast"].empty()) && options["tables_file"].empty() && options["stdout"].empty())
+      {
         option.append(";f=+").append(escape_bs(options["outfile"]));      
+        tables = options["outfile"];
+      }
       try
       {
         reflex::Pattern pattern(patterns[start], option);
+        if (pattern.table_words() > 0)
+          statics.push_back(conditions[start]);
         reflex::Pattern::Index accept = 1;
         for (size_t rule = 0; rule < rules[start].size(); ++rule)
           if (rules[start][rule].regex != "<<EOF>>")
@@ -3086,8 +3160,10 @@ void Reflex::stats()
           std::cout
             << "\n"
             << std::setw(10) << pattern.nodes() << " nodes (" << pattern.nodes_time() << " ms)\n"
-            << std::setw(10) << pattern.edges() << " edges (" << pattern.edges_time() << " ms)\n"
-            << std::setw(10) << pattern.words() << " words (" << pattern.words_time() << " ms)\n";
+            << std::setw(10) << pattern.edges() << " edges (" << pattern.edges_time() << " ms)\n";
+          if (pattern.byte_classes() > 0)
+            std::cout << std::setw(10) << pattern.byte_classes() << " byte classes\n";
+          std::cout << std::setw(10) << pattern.words() << " words (" << pattern.words_time() << " ms)\n";
         }
       }
       catch (reflex::regex_error& e)
@@ -3095,8 +3171,48 @@ void Reflex::stats()
         abort("malformed regular expression\n", e.what());
       }
     }
+    if (!options["static"].empty() && !tables.empty())
+      write_static_tables(tables, statics);
     if (!options["verbose"].empty())
       std::cout << std::endl;
   }
 }
 
+/// Write the definition of the static dense tables of the start conditions after the generated tables
+void Reflex::write_static_tables(const std::string& filename, const std::vector<std::string>& statics)
+{
+  std::ofstream ofs(filename.c_str(), std::ofstream::out | std::ofstream::app);
+  if (!ofs.is_open())
+    abort("cannot open file ", filename.c_str());
+  std::ostream *os = out;
+  out = &ofs;
+  if (!options["namespace"].empty())
+    write_namespace_open();
+  // a separate tables file does not include the lexer class declaration of reflex_tables
+  if (filename != options["outfile"])
+    *out <<
+      "struct reflex_tables {\n"
+      "  static const reflex::Pattern::Index *table(const reflex::Pattern::Opcode *code, const uint8_t*& bcl);\n"
+      "};\n"
+      "\n";
+  *out <<
+    "const reflex::Pattern::Index *reflex_tables::table(const reflex::Pattern::Opcode *code, const uint8_t*& bcl)\n"
+    "{\n";
+  if (statics.empty())
+    *out << "  (void)code;\n  (void)bcl;\n  return NULL;\n";
+  else
+    *out << "  const reflex::Pattern::Index *tbl;\n";
+  for (std::vector<std::string>::const_iterator i = statics.begin(); i != statics.end(); ++i)
+    *out <<
+      "  if ((tbl = reflex_tables_" << *i << "::table(code, bcl)) != NULL)\n"
+      "    return tbl;\n";
+  if (!statics.empty())
+    *out << "  return NULL;\n";
+  *out << "}\n";
+  if (!options["namespace"].empty())
+    write_namespace_close();
+  if (!ofs.good())
+    abort("error in writing");
+  out = os;
+}
+
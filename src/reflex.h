@@ -161,6 +161,7 @@ class Reflex
   void        write_namespace_scope();
   void        undot_namespace(std::string& s);
   void        stats();
+  void        write_static_tables(const std::string& filename, const std::vector<std::string>& statics);
   bool        get_line();
   bool        skip_comment(size_t& pos);
   bool        is(const char *s);
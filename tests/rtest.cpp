@@ -4,7 +4,15 @@
 // Or disable trigraphs by enabling the GNU standard:
 // c++ -std=gnu++11 -Wall test.cpp pattern.cpp matcher.cpp
 
+#include <reflex/decompress.h>
 #include <reflex/matcher.h>
+#include <reflex/parfinder.h>
+#include <reflex/parscanner.h>
+#include <reflex/patcache.h>
+#include <reflex/readahead.h>
+#include <reflex/staticmatcher.h>
+#include <sstream>
+#include <thread>
 
 // #define INTERACTIVE // for interactive mode testing
 
@@ -49,6 +57,17 @@ class WrappedMatcher : public Matcher {
   int source;
 };
 
+// static tables for StaticMatcher that return the dense table of static_pattern for any pattern
+static const Pattern *static_pattern = NULL;
+
+struct StaticTables {
+  static const Pattern::Index *table(const Pattern::Opcode*, const uint8_t*& bcl)
+  {
+    bcl = static_pattern->byte_class();
+    return static_pattern->table();
+  }
+};
+
 struct Test {
   const char *pattern;
   const char *popts;
@@ -249,19 +268,21 @@ Test tests[] = {
   { NULL, NULL, NULL, NULL, { } }
 };
 
-int main()
+static void test_patterns(const char *extra)
 {
-  banner("PATTERN TESTS");
   for (const Test *test = tests; test->pattern != NULL; ++test)
   {
-    Pattern pattern(test->pattern, test->popts);
+    std::string popts(test->popts);
+    if (*extra)
+      popts.append(*test->popts ? ";" : "").append(extra);
+    Pattern pattern(test->pattern, popts);
     Matcher matcher(pattern, test->cstring, test->mopts);
 #ifdef INTERACTIVE
     matcher.interactive();
 #endif
     printf("Test \"%s\" against \"%s\"\n", test->pattern, test->cstring);
-    if (*test->popts)
-      printf("With pattern options \"%s\"\n", test->popts);
+    if (!popts.empty())
+      printf("With pattern options \"%s\"\n", popts.c_str());
     if (*test->mopts)
       printf("With matcher options \"%s\"\n", test->mopts);
     for (Pattern::Index i = 1; i <= pattern.size(); ++i)
@@ -281,13 +302,25 @@ int main()
         printf("ERROR: remaining input rest = '%s'; dumping dump.gv and dump.cpp\n", matcher.rest());
       else
         printf("ERROR: accept = %zu text = '%s'; dumping dump.gv and dump.cpp\n", matcher.accept(), matcher.text());
-      std::string options(test->popts);
+      std::string options(popts);
       options.append(";f=dump.gv,dump.cpp");
       Pattern(test->pattern, options);
       exit(1);
     }
     printf("OK\n\n");
   }
+}
+
+int main()
+{
+  banner("PATTERN TESTS");
+  test_patterns("");
+  banner("PATTERN TESTS WITH DENSE TRANSITION TABLES");
+  test_patterns("d");
+  banner("PATTERN TESTS WITH DFA MINIMIZATION");
+  test_patterns("h");
+  banner("PATTERN TESTS WITH LAZY DFA CONSTRUCTION");
+  test_patterns("l");
   Pattern pattern1("\\w+|\\W", "f=dump.cpp");
   Pattern pattern2("\\<.*\\>", "f=dump.gv");
   Pattern pattern3(" ");
@@ -315,6 +348,598 @@ int main()
   if (test != "an/apple/a/day/")
     error("find results");
   //
+  Pattern pattern8d("\\w+", "d");
+  if (pattern8d.table_words() == 0)
+    error("dense transition table");
+  if (pattern8d.byte_classes() != 2 || Pattern("\\w+").byte_classes() != 0 || pattern8d.byte_class()['a'] != pattern8d.byte_class()['_'] || pattern8d.byte_class()['a'] == pattern8d.byte_class()['-'])
+    error("byte classes");
+  if (Pattern("(abc|xbc|ybc)", "h").nodes() != 4 || Pattern("(abc|xbc|ybc)", "h").edges() != 5)
+    error("minimized nodes and edges");
+  {
+    // a DFA constructed with threads must match the same as a DFA constructed sequentially
+    Pattern sequential("(a|b)*a(a|b){10}|c(a|b|c){6}d", "j=1"), parallel("(a|b)*a(a|b){10}|c(a|b|c){6}d", "j=4");
+    if (parallel.nodes() != sequential.nodes() || parallel.edges() != sequential.edges())
+      error("parallel DFA construction");
+    std::string input;
+    for (unsigned int i = 0, r = 1; i < 100000; ++i)
+      input.push_back("abcd"[(r = r * 1103515245 + 12345) >> 16 & 3]);
+    Matcher m1(sequential, input), m2(parallel, input);
+    while (m1.find())
+      if (!m2.find() || m1.accept() != m2.accept() || m1.first() != m2.first() || m1.size() != m2.size())
+        error("parallel DFA find");
+    if (m2.find())
+      error("parallel DFA find");
+  }
+  if (Pattern("(a|b)*a(a|b){12}", "l").words() != 0)
+    error("lazy DFA");
+  {
+    // a lazy DFA with more states than fit in the cache must match the same as the DFA
+    Pattern eager("(a|b)*a(a|b){12}"), lazy("(a|b)*a(a|b){12}", "l");
+    std::string input;
+    for (unsigned int i = 0, r = 1; i < 100000; ++i)
+      input.push_back("ab"[(r = r * 1103515245 + 12345) >> 16 & 1]);
+    Matcher m1(eager, input), m2(lazy, input);
+    while (m1.find())
+      if (!m2.find() || m1.first() != m2.first() || m1.size() != m2.size())
+        error("lazy DFA find");
+    if (m2.find())
+      error("lazy DFA find");
+  }
+  {
+    // a compiled pattern saved to a file and loaded memory mapped must match the same
+    Pattern saved("(a)pple|d(a)y|\\d+x"), loaded;
+    if (!saved.save("dump.pat") || !loaded.load_mapped("dump.pat"))
+      error("save and load_mapped");
+    if (loaded.size() != saved.size() || loaded[2] != saved[2] || loaded.words() != saved.words() || !loaded.reachable(3))
+      error("load_mapped subpatterns");
+    Matcher m1(saved, "an apple a day 12x"), m2(loaded, "an apple a day 12x");
+    while (m1.find())
+      if (!m2.find() || m1.accept() != m2.accept() || m1.first() != m2.first() || m1.size() != m2.size())
+        error("load_mapped find");
+    if (m2.find())
+      error("load_mapped find");
+    Pattern copied(loaded);
+    if (copied.words() != saved.words() || !Matcher(copied, "a day").find())
+      error("load_mapped copy");
+    if (loaded.load_mapped("dump.cpp") || !loaded.empty())
+      error("load_mapped invalid file");
+    // corrupt GOTO targets and subpattern locations are rejected
+    std::vector<uint32_t> words((32 + 4 * saved.words() + 4 * saved.size()) / 4);
+    FILE *fd = NULL;
+    if ((fd = ::fopen("dump.pat", "rb")) == NULL || ::fread(&words[0], 4, words.size(), fd) != words.size())
+      error("load_mapped read file");
+    if (fd != NULL)
+      ::fclose(fd);
+    for (int k = 0; k < 2; ++k)
+    {
+      std::vector<uint32_t> bad(words);
+      if (k == 0)
+        bad[8 + saved.words() - 1] = 0x00FF0000 | static_cast<uint32_t>(saved.words()); // GOTO 0x00-0xFF beyond the last opcode
+      else
+        bad[8 + saved.words()] = 0xFFFF;
+      Pattern corrupt;
+      if (!saved.save("dump.pat") || (fd = ::fopen("dump.pat", "r+b")) == NULL)
+        error("load_mapped write file");
+      ::fwrite(&bad[0], 4, bad.size(), fd);
+      ::fclose(fd);
+      if (corrupt.load_mapped("dump.pat") || !corrupt.empty())
+        error("load_mapped corrupt file");
+    }
+  }
+  {
+    // cached patterns are shared and the least recently used pattern is evicted when over budget
+    PatternCache cache;
+    PatternCache::Handle p1 = cache.get("\\w+"), p2 = cache.get("\\d+"), p3 = cache.get("\\w+");
+    if (p1 != p3 || p1 == p2 || cache.hits() != 1 || cache.misses() != 2 || cache.size() != 2)
+      error("pattern cache get");
+    if (cache.get("\\w+", "i") == p1)
+      error("pattern cache options");
+    cache.budget(cache.bytes() - 1);
+    if (cache.size() != 2 || cache.evictions() != 1 || cache.get("\\w+", "i") != cache.get("\\w+", "i"))
+      error("pattern cache eviction");
+    if (!Matcher(*p2, "a 12").find())
+      error("pattern cache evicted pattern");
+    size_t misses = cache.misses();
+    if (cache.get("\\w+") != p1 || cache.misses() != misses || cache.get("\\d+") == p2 || cache.misses() != misses + 1)
+      error("pattern cache least recently used");
+    if (Pattern("\\w+", "l").bytes() <= Pattern().bytes())
+      error("pattern bytes");
+  }
+  {
+    // threads share the cached patterns, each lookup is counted once as a hit or a miss
+    PatternCache cache;
+    const char *regex[] = { "\\w+", "\\d+", "[a-z]+", "\\s+" };
+    std::vector<PatternCache::Handle> handles[4];
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+      threads.push_back(std::thread([&cache, &regex, &handles, t]() {
+        for (int i = 0; i < 1000; ++i)
+          handles[t].push_back(cache.get(regex[i % 4]));
+      }));
+    for (int t = 0; t < 4; ++t)
+      threads[t].join();
+    if (cache.size() != 4 || cache.hits() + cache.misses() != 4000 || cache.hits() < 4000 - 16)
+      error("pattern cache threads");
+    for (int t = 0; t < 4; ++t)
+      for (int i = 0; i < 1000; ++i)
+        if (handles[t][i] != cache.get(regex[i % 4]))
+          error("pattern cache threads share");
+  }
+  {
+    // a buffer searched in chunks by threads must give the same matches as find()
+    std::string text;
+    for (int i = 0; i < 1000; ++i)
+      text.append(i % 7 ? "an apple a day\n" : "\n").append(i % 3 ? "keeps the\tdoctor away\n" : "");
+    Matcher matcher("(?m)\\<a\\w*|^\\w+");
+    ParallelFinder<> finder(matcher, 4, 100);
+    std::vector<ParallelFinder<>::Match> matches;
+    size_t n = finder.find(text.data(), text.size(), matches);
+    matcher.input(text);
+    size_t i = 0;
+    while (matcher.find())
+    {
+      if (i >= n || matches[i].first != matcher.first() || matches[i].size != matcher.size() || matches[i].lineno != matcher.lineno() || matches[i].columno != matcher.columno() || matches[i].accept != matcher.accept())
+        error("parallel find");
+      ++i;
+    }
+    if (i != n)
+      error("parallel find count");
+  }
+  {
+    // a buffer tokenized speculatively in chunks by threads must give the same tokens as scan()
+    std::string text;
+    for (int i = 0; i < 1000; ++i)
+      text.append(i % 5 ? "int x = \"a b\";\n" : "/* a\n comment\n */\n\n").append(i % 3 ? "\tx += 1;\n" : "");
+    for (int k = 0; k < 2; ++k)
+    {
+      if (k == 1)
+        text[text.size() / 2] = '#';
+      Matcher matcher(k == 0 ? "(/\\*(.|\\n)*?\\*/)|(\"[^\"]*\")|(\\w+)|(\\s+)|(.)" : "/\\*(.|\\n)*?\\*/|\"[^\"]*\"|\\w+|\\s+|[=+;]");
+      ParallelScanner<> scanner(matcher, 3, 50);
+      std::vector<ParallelScanner<>::Token> tokens;
+      size_t n = scanner.scan(text.data(), text.size(), tokens);
+      if (k == 1 && scanner.rescans() == 0)
+        error("parallel scan rescans");
+      matcher.input(text);
+      size_t i = 0, accept;
+      while ((accept = matcher.scan()) != 0)
+      {
+        if (i >= n || tokens[i].first != matcher.first() || tokens[i].size != matcher.size() || tokens[i].lineno != matcher.lineno() || tokens[i].columno != matcher.columno() || tokens[i].accept != accept)
+          error("parallel scan");
+        ++i;
+      }
+      if (i != n || (k == 1) != (tokens.back().first + tokens.back().size < text.size()))
+        error("parallel scan count");
+    }
+  }
+  {
+    // the SIMD prefix search of advance() must find a pattern prefix at any alignment of the buffer
+    Pattern prefix1("needle"), prefix2("needle\\d");
+    for (size_t k = 0; k < 70; ++k)
+    {
+      std::string text(k, 'e');
+      text.append("nedle needl neeedle eedle ").append(k % 3 ? "needle7" : "needlex").append(k, 'n');
+      Matcher matcher(prefix1, text);
+      if (!matcher.find() || matcher.first() != text.find("needle"))
+        error("find prefix");
+      matcher.pattern(prefix2);
+      matcher.input(text);
+      if ((k % 3 != 0) != matcher.find() || (k % 3 != 0 && matcher.first() != text.find("needle")))
+        error("find prefix with predictor");
+    }
+  }
+  {
+    // the SIMD multi-literal search of advance() must find keywords without a common prefix at any alignment of the buffer
+    Pattern keywords("while|for|do|if|else|switch|case|return|goto|break|continue|default");
+    for (size_t k = 0; k < 70; ++k)
+    {
+      std::string text(k, ' ');
+      text.append("whle frk dx ixf els swtch cas retrn gto brk cntinue dflt if ").append(k % 2 ? "goto" : "gota").append(k, 'x');
+      Matcher matcher(keywords, text);
+      if (matcher.find() != 4 || matcher.first() != text.find("if") || matcher.find() != (k % 2 ? 9 : 0) || (k % 2 != 0 && matcher.first() != text.find("goto")))
+        error("find keywords");
+    }
+  }
+  {
+    // the Aho-Corasick search of advance() must find the longest of more than 4096 overlapping strings with their accept indices
+    std::vector<std::string> words;
+    std::string regex;
+    for (size_t i = 0; i < 5000; ++i)
+    {
+      std::string word;
+      for (size_t j = i + 1; j > 0; j /= 26)
+        word.push_back(static_cast<char>('a' + j % 26));
+      words.push_back(word);
+      regex.append(i > 0 ? "|" : "").append(word);
+    }
+    Pattern strings(regex), istrings(regex, "i");
+    std::string text;
+    for (size_t k = 0; k < 2000; ++k)
+      text.append(words[k * 37 % 5000]).append(k % 3 + 1, '-');
+    Matcher matcher(strings, text);
+    for (size_t k = 0; k < 2000; ++k)
+      if (matcher.find() != k * 37 % 5000 + 1 || matcher.str() != words[k * 37 % 5000])
+        error("find strings");
+    if (matcher.find() != 0)
+      error("find strings end");
+    // the trie of the automaton matches the strings without a DFA, unless a DFA is requested, and must split the same as the DFA
+    Pattern dfa(regex, "h");
+    if (strings.words() != 0 || strings.nodes() == 0 || dfa.words() == 0 || Matcher(strings, words[42]).scan() != 43)
+      error("match strings");
+    std::istringstream in1(text), in2(text);
+    Matcher trie(strings, in1), full(dfa, in2);
+    trie.buffer(64);
+    full.buffer(64);
+    while (true)
+    {
+      size_t accept = trie.split();
+      if (accept != full.split() || trie.str() != full.str())
+        error("split strings");
+      if (accept == 0)
+        break;
+    }
+    for (size_t i = 0; i < text.size(); ++i)
+      text[i] = static_cast<char>(std::toupper(text[i]));
+    matcher.pattern(istrings);
+    matcher.input(text);
+    for (size_t k = 0; k < 2000; ++k)
+      if (matcher.find() != k * 37 % 5000 + 1)
+        error("find case-insensitive strings");
+  }
+  {
+    // the reverse DFA search of advance() from the required factor "@example.com" must find the leftmost start of each match
+    Pattern factor("\\w+@example\\.com");
+    std::string text;
+    for (size_t k = 0; k < 500; ++k)
+      text.append(k % 7 + 1, 'a').append(k % 3 ? "@example.org " : "@example.com@example.com ").append(k % 5, '.');
+    std::istringstream in(text);
+    Matcher matcher(factor, in);
+    matcher.buffer(64);
+    for (size_t k = 0; k < 500; k += 3)
+      if (!matcher.find() || matcher.str() != std::string(k % 7 + 1, 'a').append("@example.com"))
+        error("find factor");
+    if (matcher.find() != 0)
+      error("find factor end");
+  }
+  {
+    // the 64-bit bitap prediction of advance() must find matches of at least 14 bytes among shorter words
+    Pattern wide("[a-z]{14}");
+    std::string text;
+    for (size_t k = 0; k < 500; ++k)
+      text.append(std::string(k % 17 + 1, static_cast<char>('a' + k % 26))).append(k % 4 ? " " : "\n");
+    std::istringstream in(text);
+    Matcher matcher(wide, in);
+    matcher.buffer(32);
+    for (size_t k = 0; k < 500; ++k)
+      if (k % 17 >= 13 && (!matcher.find() || matcher.str() != std::string(14, static_cast<char>('a' + k % 26))))
+        error("find wide");
+    if (matcher.find() != 0)
+      error("find wide end");
+  }
+  {
+    // StaticMatcher must scan with the dense table of its static tables the same as Matcher with the opcode table
+    const char *regex = "([A-Za-z_]\\w*)|([0-9]+)|(\\s+)|(/\\*(.|\\n)*?\\*/)|(.)";
+    Pattern opcodes(regex), dense(regex, "d");
+    if (dense.table() == NULL)
+      error("static table");
+    static_pattern = &dense;
+    std::string text;
+    for (size_t k = 0; k < 300; ++k)
+      text.append("x_").append(k % 7, 'y').append(k % 3 ? " 42+" : "/* a\n*/\t");
+    Matcher matcher(opcodes, text);
+    StaticMatcher<StaticTables> static_matcher(opcodes, text);
+    size_t n = 0;
+    while (matcher.scan() != 0)
+    {
+      if (static_matcher.scan() != matcher.accept() || static_matcher.str() != matcher.str())
+        error("static scan");
+      ++n;
+    }
+    if (n != 1100 || static_matcher.scan() != 0)
+      error("static scan end");
+  }
+  {
+    // scan_batch() must store the same tokens as scan(), with and without a dense table, also when reading input in small blocks
+    const char *regex = "([A-Za-z_]\\w*)|([0-9]+)|(\\s+)|(.)";
+    Pattern opcodes(regex), dense(regex, "d");
+    std::string text;
+    for (size_t k = 0; k < 300; ++k)
+      text.append("x_").append(k % 7, 'y').append(k % 3 ? " 42+" : "\n");
+    for (int d = 0; d < 2; ++d)
+    {
+      std::istringstream in(text);
+      Matcher matcher(opcodes, text);
+      Matcher batch_matcher(d ? dense : opcodes, in);
+      batch_matcher.buffer(16);
+      Matcher::Token batch[7];
+      size_t n = 0, m;
+      while ((m = batch_matcher.scan_batch(batch, 7, true)) > 0)
+      {
+        for (size_t k = 0; k < m; ++k, ++n)
+          if (matcher.scan() != batch[k].accept || matcher.first() != batch[k].first || matcher.size() != batch[k].size || matcher.lineno() != batch[k].lineno)
+            error("scan batch");
+      }
+      if (n != 1000 || matcher.scan() != 0)
+        error("scan batch end");
+    }
+  }
+  {
+    // view() scans a read-only buffer in place without modifying it, also with text(), span() and unput()
+    const std::string text("one two\nthree four");
+    const std::string copy(text);
+    Pattern words("\\w+");
+    Matcher matcher(words);
+    matcher.view(text.data(), text.size());
+    if (!matcher.readonly())
+      error("view readonly");
+    std::string result;
+    while (matcher.find())
+      result.append(matcher.text()).append("/");
+    if (result != "one/two/three/four/")
+      error("view find");
+    matcher.view(text.data(), 7);
+    if (matcher.scan() != 1 || std::strcmp(matcher.text(), "one") != 0 || std::strcmp(matcher.span(), "one two") != 0)
+      error("view span");
+    matcher.unput('x');
+    matcher.unput('o');
+    if (matcher.find() != 1 || matcher.str() != "o")
+      error("view unput");
+    if (text != copy)
+      error("view modified");
+  }
+  {
+    // MappedFile maps a regular file to scan in place, UTF-8 BOM is skipped, UTF-16 is read with the FILE*
+    FILE *fd = ::tmpfile();
+    if (fd == NULL)
+      error("mapped file tmpfile");
+    ::fputs("\xef\xbb\xbfone two\nthree four", fd);
+    ::rewind(fd);
+    Pattern words("\\w+");
+    std::string result;
+    {
+      MappedFile file(fd);
+      Matcher matcher(words, file);
+      if (file.mapped() != matcher.readonly() || (file.mapped() && file.size() != 18))
+        error("mapped file");
+      while (matcher.find())
+        result.append(matcher.text()).append(1, ':').append(1, static_cast<char>('0' + matcher.lineno())).append("/");
+    }
+    if (result != "one:1/two:1/three:2/four:2/")
+      error("mapped file find");
+    ::fclose(fd);
+    fd = ::tmpfile();
+    if (fd == NULL)
+      error("mapped file tmpfile");
+    ::fwrite("\xfe\xff\0a\0b", 1, 6, fd);
+    ::rewind(fd);
+    {
+      MappedFile file(fd);
+      Matcher matcher(words, file);
+      if (file.mapped() || matcher.readonly() || matcher.find() != 1 || matcher.str() != "ab")
+        error("mapped file UTF-16");
+    }
+    ::fclose(fd);
+    // a mapped file with a file encoding other than plain or UTF-8 is decoded with the FILE*
+    fd = ::tmpfile();
+    if (fd == NULL)
+      error("mapped file tmpfile");
+    ::fputs("caf\xe9 na\xefve", fd);
+    for (int k = 0; k < 2; ++k)
+    {
+      ::rewind(fd);
+      MappedFile file(fd);
+      Input in(k == 0 ? Input(file, Input::file_encoding::latin) : Input(file));
+      if (k == 1)
+        in.file_encoding(Input::file_encoding::latin);
+      Matcher matcher("[^ ]+", in);
+      if (matcher.readonly() || matcher.find() != 1 || matcher.str() != "caf\xc3\xa9" || matcher.find() != 1 || matcher.str() != "na\xc3\xafve")
+        error("mapped file latin-1");
+    }
+    ::fclose(fd);
+  }
+  {
+    // UTF-16 and UTF-32 files are converted to UTF-8 in blocks, the result does not depend on the buffer size
+    static const unsigned int units[] = { 'a', 'b', 0xE9, ' ', 0x20AC, 0xD83D, 0xDE00, 0xD800, 'x', 0xDC00, '\n' };
+    const std::string utf8("ab\xc3\xa9 \xe2\x82\xac\xf0\x9f\x98\x80" REFLEX_NONCHAR_UTF8 REFLEX_NONCHAR_UTF8 "\n");
+    for (int e = 0; e < 4; ++e)
+    {
+      FILE *fd = ::tmpfile();
+      if (fd == NULL)
+        error("UTF-16/32 tmpfile");
+      ::fwrite(e == 0 ? "\xfe\xff" : e == 1 ? "\xff\xfe" : e == 2 ? "\0\0\xfe\xff" : "\xff\xfe\0\0", 1, e < 2 ? 2 : 4, fd);
+      std::string expect;
+      for (int i = 0; i < 100; ++i)
+      {
+        for (size_t j = 0; j < sizeof(units)/sizeof(units[0]); ++j)
+        {
+          unsigned int c = units[j];
+          if (e >= 2 && c >= 0xD800 && c < 0xE000)
+            continue;
+          unsigned char b[4] = { static_cast<unsigned char>(c >> 24), static_cast<unsigned char>(c >> 16), static_cast<unsigned char>(c >> 8), static_cast<unsigned char>(c) };
+          if (e == 1 || e == 3)
+          {
+            std::swap(b[0], b[3]);
+            std::swap(b[1], b[2]);
+          }
+          ::fwrite(e == 0 ? b + 2 : b, 1, e < 2 ? 2 : 4, fd);
+        }
+        expect.append(e < 2 ? utf8 : "ab\xc3\xa9 \xe2\x82\xacx\n");
+        for (int k = 0; k < i % 20; ++k)
+        {
+          unsigned char b[4] = { 0, 0, 0, 0 };
+          b[e == 0 ? 1 : e == 2 ? 3 : 0] = static_cast<unsigned char>('0' + k);
+          ::fwrite(b, 1, e < 2 ? 2 : 4, fd);
+          expect.push_back(static_cast<char>('0' + k));
+        }
+      }
+      for (size_t n = 1; n <= 4096; n *= 8)
+      {
+        ::rewind(fd);
+        Input input(fd);
+        std::string result;
+        char buf[4096];
+        size_t k;
+        while ((k = input.get(buf, n)) > 0)
+          result.append(buf, k);
+        if (result != expect)
+          error("UTF-16/32 file conversion");
+      }
+      ::fclose(fd);
+    }
+  }
+  {
+    // 8-bit code page files are converted to UTF-8 in blocks, the result does not depend on the buffer size
+    FILE *fd = ::tmpfile();
+    if (fd == NULL)
+      error("code page tmpfile");
+    std::string latin, ebcdic;
+    for (int i = 0; i < 100; ++i)
+    {
+      ::fwrite("abcdefghijklmnopqrstuvwxyz \xe9\xe8\n", 1, 30, fd);
+      latin.append("abcdefghijklmnopqrstuvwxyz \xc3\xa9\xc3\xa8\n");
+    }
+    for (int e = 0; e < 2; ++e)
+    {
+      for (size_t n = 1; n <= 4096; n *= 8)
+      {
+        ::rewind(fd);
+        Input input(fd, e == 0 ? Input::file_encoding::latin : Input::file_encoding::ebcdic);
+        std::string result;
+        char buf[4096];
+        size_t k;
+        while ((k = input.get(buf, n)) > 0)
+          result.append(buf, k);
+        if (e == 1 && n == 1)
+          ebcdic = result;
+        if (result != (e == 0 ? latin : ebcdic))
+          error("code page file conversion");
+      }
+    }
+    ::fclose(fd);
+  }
+  {
+    // ReadAheadBuffer reads input ahead in a background thread into a ring of blocks
+    FILE *fd = ::tmpfile();
+    if (fd == NULL)
+      error("read ahead tmpfile");
+    for (int i = 0; i < 10000; ++i)
+      ::fprintf(fd, "line %d\n", i);
+    Pattern words("\\w+");
+    std::string expect, result;
+    ::rewind(fd);
+    Matcher matcher(words, fd);
+    while (matcher.find())
+      expect.append(matcher.text()).append("/");
+    ::rewind(fd);
+    {
+      ReadAheadBuffer buffer(Input(fd), 3, 4096);
+      std::istream stream(&buffer);
+      matcher.input(stream);
+      while (matcher.find())
+        result.append(matcher.text()).append("/");
+    }
+    if (result != expect || matcher.lineno() != 10001)
+      error("read ahead");
+    ::rewind(fd);
+    {
+      ReadAheadBuffer buffer(Input(fd), 2, 16); // stop the reader thread before the input is consumed
+    }
+    ::fclose(fd);
+  }
+  {
+    // DecompressBuffer reads uncompressed files as is
+    FILE *fd = ::tmpfile();
+    if (fd == NULL)
+      error("decompress tmpfile");
+    for (int i = 0; i < 10000; ++i)
+      ::fprintf(fd, "line %d\n", i);
+    ::rewind(fd);
+    DecompressBuffer buffer(fd);
+    std::istream stream(&buffer);
+    Matcher matcher("line \\d+\n", stream);
+    size_t n = 0;
+    while (matcher.scan())
+      ++n;
+    if (n != 10000 || !matcher.at_end() || buffer.compression() != DecompressBuffer::compression::plain || buffer.error())
+      error("decompress plain");
+    ::fclose(fd);
+  }
+  if (!DecompressBuffer::supported(DecompressBuffer::compression::plain))
+    error("decompress supported plain");
+  if (DecompressBuffer::supported(DecompressBuffer::compression::gzip))
+  {
+    // DecompressBuffer decompresses concatenated gzip members when the library is configured with zlib
+    static const char gz[] =
+      "\x1F\x8B\x08\x00\x00\x00\x00\x00\x02\x03\x4B\xAF\xCA\x2C\x50\xC8\xC9\xCC\x4B\x55\x30\xE4\x02\x00\xF4\xD9\x67\x48\x0C\x00\x00\x00"
+      "\x1F\x8B\x08\x00\x00\x00\x00\x00\x02\x03\x4B\xAF\xCA\x2C\x50\xC8\xC9\xCC\x4B\x55\x30\xE2\x02\x00\x37\x8A\x4A\x63\x0C\x00\x00\x00";
+    FILE *fd = ::tmpfile();
+    if (fd == NULL)
+      error("decompress tmpfile");
+    ::fwrite(gz, 1, sizeof(gz) - 1, fd);
+    ::rewind(fd);
+    DecompressBuffer buffer(fd);
+    std::istream stream(&buffer);
+    std::string text;
+    Matcher matcher(".*\n", stream);
+    while (matcher.scan())
+      text.append(matcher.text());
+    if (text != "gzip line 1\ngzip line 2\n" || buffer.compression() != DecompressBuffer::compression::gzip || buffer.error())
+      error("decompress gzip");
+    ::fclose(fd);
+  }
+  {
+    // lineno(), columno(), lines() and columno_end() over long lines with tabs and UTF-8
+    std::string text;
+    for (int i = 0; i < 100; ++i)
+    {
+      for (int j = 0; j < i; ++j)
+        text.append(j % 7 == 0 ? "\t" : j % 5 == 0 ? "\xE2\x82\xAC" : "ab ");
+      text.append(i % 3 == 0 ? "\n\n" : "\n");
+    }
+    Matcher matcher("[^\\t ]{1,40}|[\\t ]", text);
+    size_t lno = 1, cno = 0, k = 0;
+    while (matcher.scan())
+    {
+      if (matcher.lineno() != lno || matcher.columno() != cno)
+        error("lineno and columno");
+      size_t n = 1;
+      const char *e = text.c_str() + matcher.last();
+      for (const char *s = text.c_str() + matcher.first(); s < e; ++s)
+      {
+        if (*s == '\n')
+        {
+          ++n;
+          k = 0;
+        }
+        else if (*s == '\t')
+        {
+          k += 1 + (~k & 7);
+        }
+        else
+        {
+          k += (*s & 0xC0) != 0x80;
+        }
+      }
+      if (matcher.lines() != n || matcher.columno_end() != (e[-1] == '\n' || k == 0 ? 0 : k - 1))
+        error("lines and columno_end");
+      lno += n - 1;
+      cno = k;
+    }
+    if (lno != 135)
+      error("lineno at end");
+  }
+  matcher.pattern(pattern8d);
+  matcher.input("an apple a day");
+  test = "";
+  while (matcher.find())
+  {
+    std::cout << matcher.text() << "/";
+    test.append(matcher.text()).append("/");
+  }
+  std::cout << std::endl;
+  if (test != "an/apple/a/day/")
+    error("find with dense transition table results");
+  //
   matcher.pattern(pattern5);
   matcher.reset("N");
   matcher.input("a a");